@@ -7,6 +7,13 @@
 
 #include <cstddef>
 #include <cmath>
+#include <initializer_list>
+#include <chrono>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <string>
+#include <stdexcept>
 
 namespace datasketches {
 
@@ -66,4 +73,65 @@ size_t get_num_trials(size_t x, size_t lg_min_x, size_t lg_max_x, size_t lg_min_
   return (size_t) pow(2, lg_trials);
 }
 
+/*
+ * Derives an independent seed for a given trial at a given stream length from the base seed of a run.
+ * This makes the result of a trial independent of which thread executes it and in what order,
+ * so that parallel and serial runs with the same base seed produce identical output.
+ * The mixing function is the finalizer of SplitMix64.
+ */
+uint64_t derive_seed(uint64_t base_seed, uint64_t stream_length, uint64_t trial) {
+  uint64_t z = base_seed;
+  for (uint64_t v: {stream_length, trial}) {
+    z += 0x9e3779b97f4a7c15ULL + v;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+  }
+  return z;
+}
+
+/*
+ * Base seed of the random inputs of this run, the same for all calls.
+ * Taken from the environment variable CHARACTERIZATION_SEED (set by --seed) to reproduce a run,
+ * otherwise from the clock. The value is recorded in the metadata of the JSON output.
+ */
+uint64_t get_run_seed() {
+  static const uint64_t seed = []() {
+    const char* env = getenv("CHARACTERIZATION_SEED");
+    if (env != nullptr) {
+      char* end;
+      errno = 0;
+      const unsigned long long value = strtoull(env, &end, 10);
+      if (!isdigit((unsigned char) env[0]) || *end != 0 || errno == ERANGE) {
+        throw std::invalid_argument(std::string("invalid seed ") + env + ", expected a non-negative integer");
+      }
+      return (uint64_t) value;
+    }
+    return (uint64_t) std::chrono::system_clock::now().time_since_epoch().count();
+  }();
+  return seed;
+}
+
+/*
+ * Path of a trace to replay instead of the generated input of the timing profiles,
+ * from the environment variable CHARACTERIZATION_TRACE, empty if not set.
+ */
+std::string get_trace_path() {
+  const char* env = getenv("CHARACTERIZATION_TRACE");
+  return env != nullptr ? env : "";
+}
+
+/*
+ * Name of the internal representation (flavor) of a CPC sketch with the given number of coupons.
+ * These are the same boundaries as the sketch uses to choose its representation.
+ */
+const char* get_cpc_flavor_name(unsigned lg_k, uint64_t num_coupons) {
+  const uint64_t k = 1 << lg_k;
+  if (num_coupons == 0) return "empty";
+  if ((num_coupons << 5) < 3 * k) return "sparse";
+  if ((num_coupons << 1) < k) return "hybrid";
+  if ((num_coupons << 3) < 27 * k) return "pinned";
+  return "sliding";
+}
+
 } /* namespace datasketches */
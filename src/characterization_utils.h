@@ -7,12 +7,18 @@
 #define CHARACTERIZATION_UTIL_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace datasketches {
 
 size_t pwr_2_law_next(size_t ppo, size_t cur_point);
 size_t count_points(size_t lg_start, size_t lg_end, size_t ppo);
 size_t get_num_trials(size_t x, size_t lg_min_x, size_t lg_max_x, size_t lg_min_trials, size_t lg_max_trials);
+uint64_t derive_seed(uint64_t base_seed, uint64_t stream_length, uint64_t trial);
+uint64_t get_run_seed();
+std::string get_trace_path();
+const char* get_cpc_flavor_name(unsigned lg_k, uint64_t num_coupons);
 
 } /* namespace datasketches */
 
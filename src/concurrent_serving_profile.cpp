@@ -0,0 +1,384 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "concurrent_serving_profile.h"
+#include "timing_core.h"
+#include "characterization_utils.h"
+#include "cpu_isolation.h"
+#include "trial_scheduler.h"
+#include "trace_input.h"
+#include "zipf_distribution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <kll_sketch.hpp>
+#include <frequent_items_sketch.hpp>
+
+namespace datasketches {
+
+/*
+ * The sketch and its queries:
+ *   void query(const sketch_type&, size_t i) const; // the i-th query of a reader
+ *   static bool modifies(size_t i);                 // true if the i-th query changes the sketch despite being const
+ *   static void freeze(const sketch_type&);         // brings the sketch into a state in which no query changes it
+ */
+
+// queries alternate between a quantile, a rank and a CDF of 20 points, the input is the kll-timing dataset
+struct kll_serving_traits {
+  typedef kll_sketch<float> sketch_type;
+  typedef float item_type;
+
+  static const size_t num_split_points = 20;
+  static const uint64_t dataset_seed = 1;
+  static const size_t dataset_length = 1 << 24;
+
+  timing_input<float> input;
+  float split_points[num_split_points];
+
+  kll_serving_traits():
+  input("uniform_float_0_1_seed" + std::to_string(dataset_seed), dataset_length,
+      [](float* items, size_t num_items) {
+        std::default_random_engine generator(dataset_seed);
+        std::uniform_real_distribution<float> distribution(0.0, 1.0);
+        for (size_t i = 0; i < num_items; i++) items[i] = distribution(generator);
+      }
+  )
+  {
+    for (size_t i = 0; i < num_split_points; i++) split_points[i] = (float) (i + 1) / (num_split_points + 1);
+  }
+
+  sketch_type build() const { return sketch_type(); }
+
+  void query(const sketch_type& sketch, size_t i) const {
+    switch (i % 3) {
+      case 0: do_not_optimize(sketch.get_quantile((double) (i % 1000) / 1000)); break;
+      case 1: do_not_optimize(sketch.get_rank(split_points[i % num_split_points])); break;
+      default: do_not_optimize(sketch.get_CDF(split_points, num_split_points));
+    }
+  }
+
+  // get_quantile() sorts level 0 in place (through a const_cast) if an update left it unsorted,
+  // get_rank() and get_CDF() only read
+  static bool modifies(size_t i) { return i % 3 == 0; }
+  static void freeze(const sketch_type& sketch) { do_not_optimize(sketch.get_quantile(0.5)); }
+};
+
+// queries are get_frequent_items(), the input is the fi-timing dataset
+struct frequent_items_serving_traits {
+  typedef frequent_items_sketch<long long> sketch_type;
+  typedef long long item_type;
+
+  static const unsigned lg_max_sketch_size = 10;
+  static const unsigned zipf_lg_range = 13;
+  static constexpr double zipf_exponent = 0.7;
+  static const uint64_t dataset_seed = 1;
+  static const size_t dataset_length = 1 << 24;
+
+  timing_input<long long> input;
+
+  frequent_items_serving_traits(): input(get_dataset_key(), dataset_length,
+      [](long long* items, size_t num_items) {
+        zipf_distribution zipf(1 << zipf_lg_range, zipf_exponent, dataset_seed, zipf_distribution::ALIAS_TABLE);
+        zipf.sample_n(items, num_items);
+      }
+  ) {}
+
+  static std::string get_dataset_key() {
+    std::ostringstream key;
+    key << "zipf_" << (1 << zipf_lg_range) << "_" << zipf_exponent << "_seed" << dataset_seed;
+    return key.str();
+  }
+
+  sketch_type build() const { return sketch_type(lg_max_sketch_size); }
+
+  void query(const sketch_type& sketch, size_t) const {
+    do_not_optimize(sketch.get_frequent_items(frequent_items_error_type::NO_FALSE_POSITIVES));
+  }
+
+  static bool modifies(size_t) { return false; }
+  static void freeze(const sketch_type&) {}
+};
+
+/*
+ * Ways of sharing a sketch between the writer and the readers:
+ *   void update(const item_type* items, size_t n); // called by the writer only
+ *   void read(fn, bool modifies);                   // fn(const sketch_type&), by any number of readers,
+ *                                                   // modifies if fn may change the sketch
+ *   size_t get_num_publishes() const;
+ */
+
+// one lock for everything
+template<typename Traits>
+class mutex_serving {
+public:
+  typedef typename Traits::sketch_type Sketch;
+  explicit mutex_serving(const Sketch& sketch): sketch(sketch) {}
+  template<typename T>
+  void update(const T* items, size_t n) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < n; i++) sketch.update(items[i]);
+  }
+  template<typename Fn>
+  void read(Fn&& fn, bool) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fn(static_cast<const Sketch&>(sketch));
+  }
+  size_t get_num_publishes() const { return 0; }
+  static const char* name() { return "mutex"; }
+private:
+  Sketch sketch;
+  std::mutex mutex;
+};
+
+// readers share the lock, except for queries that modify the sketch
+template<typename Traits>
+class rwlock_serving {
+public:
+  typedef typename Traits::sketch_type Sketch;
+  explicit rwlock_serving(const Sketch& sketch): sketch(sketch) {}
+  template<typename T>
+  void update(const T* items, size_t n) {
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    for (size_t i = 0; i < n; i++) sketch.update(items[i]);
+  }
+  template<typename Fn>
+  void read(Fn&& fn, bool modifies) {
+    if (modifies) {
+      std::unique_lock<std::shared_timed_mutex> lock(mutex);
+      fn(static_cast<const Sketch&>(sketch));
+    } else {
+      std::shared_lock<std::shared_timed_mutex> lock(mutex);
+      fn(static_cast<const Sketch&>(sketch));
+    }
+  }
+  size_t get_num_publishes() const { return 0; }
+  static const char* name() { return "rwlock"; }
+private:
+  Sketch sketch;
+  std::shared_timed_mutex mutex;
+};
+
+// the writer owns the sketch and publishes a frozen copy every publish_interval items,
+// readers never wait for the writer, but see results up to publish_interval items old
+template<typename Traits>
+class snapshot_serving {
+public:
+  typedef typename Traits::sketch_type Sketch;
+  static const size_t publish_interval = 1 << 14;
+
+  explicit snapshot_serving(const Sketch& sketch):
+    sketch(sketch), snapshot(make_snapshot(sketch)), num_unpublished(0), num_publishes(0) {}
+  template<typename T>
+  void update(const T* items, size_t n) {
+    for (size_t i = 0; i < n; i++) sketch.update(items[i]);
+    num_unpublished += n;
+    if (num_unpublished >= publish_interval) {
+      std::atomic_store(&snapshot, make_snapshot(sketch));
+      num_unpublished = 0;
+      num_publishes++;
+    }
+  }
+  template<typename Fn>
+  void read(Fn&& fn, bool) {
+    const std::shared_ptr<const Sketch> current = std::atomic_load(&snapshot);
+    fn(*current);
+  }
+  size_t get_num_publishes() const { return num_publishes; }
+  static const char* name() { return "snapshot"; }
+private:
+  Sketch sketch;
+  std::shared_ptr<const Sketch> snapshot;
+  size_t num_unpublished;
+  size_t num_publishes;
+
+  // frozen before the readers see it, since they share it without a lock
+  static std::shared_ptr<const Sketch> make_snapshot(const Sketch& sketch) {
+    std::shared_ptr<const Sketch> copy = std::make_shared<const Sketch>(sketch);
+    Traits::freeze(*copy);
+    return copy;
+  }
+};
+
+// latencies of one reader: the maximum and a uniform sample of fixed size (reservoir sampling)
+class latency_reservoir {
+public:
+  latency_reservoir(size_t capacity, uint64_t seed): capacity(capacity), count(0), max(0), generator(seed) {
+    samples.reserve(capacity);
+  }
+  void add(double ns) {
+    max = std::max(max, ns);
+    if (samples.size() < capacity) {
+      samples.push_back(ns);
+    } else {
+      const size_t i = std::uniform_int_distribution<size_t>(0, count)(generator);
+      if (i < capacity) samples[i] = ns;
+    }
+    count++;
+  }
+  size_t get_count() const { return count; }
+  double get_max() const { return max; }
+  const std::vector<double>& get_samples() const { return samples; }
+  // a uniform sample of n of the samples
+  void add_subsample(size_t n, std::vector<double>& sample) {
+    std::shuffle(samples.begin(), samples.end(), generator);
+    sample.insert(sample.end(), samples.begin(), samples.begin() + std::min(n, samples.size()));
+  }
+private:
+  size_t capacity;
+  size_t count;
+  double max;
+  std::vector<double> samples;
+  std::default_random_engine generator;
+};
+
+// a uniform sample of the latencies of all the queries, in which each reader has a share proportional
+// to its number of queries rather than its fixed reservoir size, as large as the reservoirs allow
+static std::vector<double> merge_reservoirs(std::vector<latency_reservoir>& reservoirs) {
+  size_t num_queries = 0;
+  for (const auto& reservoir: reservoirs) num_queries += reservoir.get_count();
+  std::vector<double> sample;
+  if (num_queries == 0) return sample;
+  double sample_size = std::numeric_limits<double>::max();
+  for (const auto& reservoir: reservoirs) {
+    if (reservoir.get_count() == 0) continue;
+    sample_size = std::min(sample_size, (double) reservoir.get_samples().size() * num_queries / reservoir.get_count());
+  }
+  for (auto& reservoir: reservoirs) {
+    reservoir.add_subsample(std::llround(sample_size * reservoir.get_count() / num_queries), sample);
+  }
+  return sample;
+}
+
+template<typename Traits, template<typename> class Serving>
+static void run_section(sweep_shard& shard, const Traits& traits) {
+  const size_t prefill_length = 1 << 20;
+  const size_t update_batch = 64; // items per lock acquisition of the writer
+  const double warmup_seconds = 0.2;
+  const double measure_seconds = 1;
+  const size_t reservoir_size = 1 << 16;
+
+  typedef typename Traits::sketch_type sketch_type;
+  typedef Serving<Traits> serving_type;
+
+  // 1, 2, 4, ... readers up to twice the hardware threads (or pinned CPUs), to show oversubscription as well
+  const unsigned max_readers = 2 * trial_scheduler().get_num_threads();
+
+  shard.begin_section(serving_type::name());
+  shard.header() << "Readers\tIngestItemsPerSec\tQueriesPerSec\tLatencyP50\tLatencyP99\tLatencyP999\tLatencyMax\tPublishesPerSec" << std::endl;
+
+  for (unsigned num_readers = 1; num_readers <= max_readers; num_readers *= 2) {
+    if (!shard.should_run(num_readers)) continue;
+
+    sketch_type initial(traits.build());
+    const auto* items = traits.input.data();
+    const size_t input_length = traits.input.size();
+    for (size_t i = 0; i < std::min(prefill_length, input_length); i++) initial.update(items[i]);
+    serving_type serving(initial);
+
+    // 0: warmup, 1: measuring, 2: stop
+    std::atomic<int> phase(0);
+    size_t num_ingested = 0;
+    size_t num_publishes = 0;
+    std::vector<latency_reservoir> latencies;
+    for (unsigned i = 0; i < num_readers; i++) latencies.emplace_back(reservoir_size, derive_seed(get_run_seed(), num_readers, i));
+
+    // the writer runs on the first pinned CPU, the readers on the next ones
+    std::thread writer([&]() {
+      pin_thread(0);
+      size_t offset = prefill_length % input_length;
+      size_t ingested = 0;
+      size_t publishes_at_start = 0;
+      bool measuring = false;
+      for (int current = phase.load(); current < 2; current = phase.load(std::memory_order_relaxed)) {
+        if (current == 1 && !measuring) {
+          measuring = true;
+          publishes_at_start = serving.get_num_publishes();
+        }
+        const size_t n = std::min(update_batch, input_length - offset);
+        serving.update(items + offset, n);
+        offset = (offset + n) % input_length;
+        if (measuring) ingested += n;
+      }
+      num_ingested = ingested;
+      num_publishes = serving.get_num_publishes() - publishes_at_start;
+    });
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < num_readers; r++) {
+      readers.emplace_back([&, r]() {
+        pin_thread(1 + r);
+        latency_reservoir& reservoir = latencies[r];
+        for (size_t i = r; ; i++) {
+          const int current = phase.load(std::memory_order_relaxed);
+          if (current == 2) break;
+          const auto start = timer::now();
+          serving.read([&traits, i](const sketch_type& sketch) { traits.query(sketch, i); }, Traits::modifies(i));
+          const double ns = timer::elapsed_ns(start);
+          if (current == 1) reservoir.add(ns);
+        }
+      });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(warmup_seconds));
+    phase.store(1);
+    const auto start = timer::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(measure_seconds));
+    phase.store(2);
+    const double elapsed_seconds = timer::elapsed_ns(start) / 1e9;
+    writer.join();
+    for (auto& reader: readers) reader.join();
+
+    size_t num_queries = 0;
+    double max_latency = 0;
+    for (const auto& reservoir: latencies) {
+      num_queries += reservoir.get_count();
+      max_latency = std::max(max_latency, reservoir.get_max());
+    }
+    std::vector<double> samples = merge_reservoirs(latencies);
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double fraction) {
+      return samples.empty() ? 0 : samples[(size_t) (fraction * (samples.size() - 1))];
+    };
+
+    shard.add_row_samples({{"Latency", samples}});
+    shard.out() << num_readers
+        << "\t" << num_ingested / elapsed_seconds
+        << "\t" << num_queries / elapsed_seconds
+        << "\t" << percentile(0.5)
+        << "\t" << percentile(0.99)
+        << "\t" << percentile(0.999)
+        << "\t" << max_latency
+        << "\t" << num_publishes / elapsed_seconds
+        << std::endl;
+  }
+}
+
+template<typename Traits>
+static void run_sections(sweep_shard& shard) {
+  const Traits traits;
+  run_section<Traits, mutex_serving>(shard, traits);
+  run_section<Traits, rwlock_serving>(shard, traits);
+  run_section<Traits, snapshot_serving>(shard, traits);
+}
+
+concurrent_serving_profile::concurrent_serving_profile(sketch_kind kind): kind(kind) {}
+
+void concurrent_serving_profile::run(sweep_shard& shard) {
+  switch (kind) {
+    case KLL: run_sections<kll_serving_traits>(shard); break;
+    case FREQUENT_ITEMS: run_sections<frequent_items_serving_traits>(shard); break;
+  }
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef CONCURRENT_SERVING_PROFILE_H_
+#define CONCURRENT_SERVING_PROFILE_H_
+
+#include "profile.h"
+
+namespace datasketches {
+
+/*
+ * One writer thread ingests into a shared sketch while a growing number of reader threads query it.
+ * Each way of sharing the sketch is a section: a mutex, a reader-writer lock, and snapshots,
+ * where the writer updates a private sketch and periodically publishes an immutable copy
+ * that the readers load atomically. A row per number of readers reports the ingest throughput,
+ * the query throughput and the tail latency of the queries, including the wait for the lock.
+ */
+class concurrent_serving_profile: public profile {
+public:
+  enum sketch_kind { KLL, FREQUENT_ITEMS };
+
+  explicit concurrent_serving_profile(sketch_kind kind);
+  virtual void run(sweep_shard& shard);
+
+private:
+  sketch_kind kind;
+};
+
+} /* namespace datasketches */
+
+#endif /* CONCURRENT_SERVING_PROFILE_H_ */
@@ -0,0 +1,15 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "counting_allocator.h"
+
+namespace datasketches {
+
+allocation_stats& allocation_stats::get() {
+  static thread_local allocation_stats stats = {0, 0, 0, 0};
+  return stats;
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef COUNTING_ALLOCATOR_H_
+#define COUNTING_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace datasketches {
+
+/*
+ * Heap usage through counting_allocator by the calling thread.
+ * Counting is per thread to avoid atomic operations in measured regions,
+ * so memory must be released by the thread that allocated it for live_bytes to be accurate.
+ */
+struct allocation_stats {
+  uint64_t num_allocations;
+  uint64_t bytes_allocated;
+  int64_t live_bytes;
+  int64_t peak_live_bytes;
+
+  static allocation_stats& get();
+};
+
+/*
+ * Standard allocator that records every allocation in allocation_stats.
+ * Sketches instantiated with it let the profiles report allocation count, bytes and peak heap per operation.
+ */
+template<typename T>
+class counting_allocator {
+public:
+  typedef T value_type;
+
+  counting_allocator() noexcept {}
+  template<typename U>
+  counting_allocator(const counting_allocator<U>&) noexcept {}
+
+  template<typename U>
+  struct rebind {
+    typedef counting_allocator<U> other;
+  };
+
+  T* allocate(size_t n) {
+    const size_t bytes = n * sizeof(T);
+    T* p = static_cast<T*>(::operator new(bytes));
+    allocation_stats& stats = allocation_stats::get();
+    stats.num_allocations++;
+    stats.bytes_allocated += bytes;
+    stats.live_bytes += bytes;
+    if (stats.live_bytes > stats.peak_live_bytes) stats.peak_live_bytes = stats.live_bytes;
+    return p;
+  }
+
+  void deallocate(T* p, size_t n) {
+    allocation_stats::get().live_bytes -= n * sizeof(T);
+    ::operator delete(p);
+  }
+};
+
+template<typename T, typename U>
+bool operator==(const counting_allocator<T>&, const counting_allocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&) { return false; }
+
+} /* namespace datasketches */
+
+#endif /* COUNTING_ALLOCATOR_H_ */
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "cpc_sketch_accuracy_profile.h"
+#include "characterization_utils.h"
+#include "trial_scheduler.h"
+#include "timing_core.h"
+#include "prefix_sweep.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <cpc_sketch.hpp>
+
+namespace datasketches {
+
+cpc_sketch_accuracy_profile::cpc_sketch_accuracy_profile(bool incremental): incremental(incremental) {}
+
+void cpc_sketch_accuracy_profile::run(sweep_shard& shard) {
+  const size_t lg_min_stream_len(0);
+  const size_t lg_max_stream_len(20);
+  const size_t ppo(16);
+
+  const size_t lg_max_trials(14);
+  const size_t lg_min_trials(8);
+
+  const int lg_k(10);
+
+  const uint64_t golden64(0x9e3779b97f4a7c13ULL);  // the golden ratio
+
+  // normal quantiles at -3, -2, -1, 0, +1, +2, +3 standard deviations
+  const double quantiles[] = {0.00135, 0.02275, 0.15866, 0.5, 0.84134, 0.97725, 0.99865};
+  const size_t num_quantiles(sizeof(quantiles) / sizeof(quantiles[0]));
+  const unsigned max_kappa(3);
+
+  // trials are seeded from this, so the output does not depend on the number of threads
+  const uint64_t seed(get_run_seed());
+
+  trial_scheduler scheduler;
+
+  shard.header() << "Stream\tTrials\tFlavor\tMeanRE\tRmsRE"
+      << "\tRE_m3SD\tRE_m2SD\tRE_m1SD\tRE_Median\tRE_p1SD\tRE_p2SD\tRE_p3SD"
+      << "\tCoverage1\tCoverage2\tCoverage3"
+      << "\tEstimate\tLowerBound\tUpperBound";
+
+  timing_column get_estimate("Estimate");
+  timing_column get_lower_bound("LowerBound");
+  timing_column get_upper_bound("UpperBound");
+  const std::vector<timing_column*> columns = {&get_estimate, &get_lower_bound, &get_upper_bound};
+  // the queries run on a sketch with std::allocator, so there are no allocation stats
+  const std::vector<timing_column*> stats_columns;
+  print_timing_summary_header(shard.header(), columns, stats_columns);
+  shard.header() << std::endl;
+
+  // writes the row of a stream length given the results of its trials,
+  // query latency is measured on the calling thread with all workers idle, on a sketch of the same flavor
+  auto write_row = [&](size_t stream_length, size_t num_trials, std::vector<double> relative_errors,
+      const unsigned char* is_covered, uint64_t num_coupons, const cpc_sketch& timing_sketch) {
+    double sum_errors(0);
+    double sum_squared_errors(0);
+    for (double error: relative_errors) {
+      sum_errors += error;
+      sum_squared_errors += error * error;
+    }
+    raw_samples samples = {{"RE", relative_errors}};
+    std::sort(relative_errors.begin(), relative_errors.end());
+
+    unsigned num_covered[max_kappa] = {0};
+    for (size_t trial = 0; trial < num_trials; trial++) {
+      for (unsigned kappa = 1; kappa <= max_kappa; kappa++) num_covered[kappa - 1] += is_covered[trial * max_kappa + kappa - 1];
+    }
+
+    for (auto column: columns) column->clear();
+    const size_t num_timing_samples(32);
+    for (size_t i = 0; i < num_timing_samples; i++) {
+      get_estimate.measure([&timing_sketch]() { do_not_optimize(timing_sketch.get_estimate()); });
+      get_lower_bound.measure([&timing_sketch]() { do_not_optimize(timing_sketch.get_lower_bound(2)); });
+      get_upper_bound.measure([&timing_sketch]() { do_not_optimize(timing_sketch.get_upper_bound(2)); });
+    }
+
+    const raw_samples timing_samples = get_raw_samples(columns);
+    samples.insert(samples.end(), timing_samples.begin(), timing_samples.end());
+    shard.add_row_samples(samples);
+    shard.out() << stream_length << "\t"
+        << num_trials << "\t"
+        << get_cpc_flavor_name(lg_k, num_coupons) << "\t"
+        << sum_errors / num_trials << "\t"
+        << std::sqrt(sum_squared_errors / num_trials);
+    for (size_t i = 0; i < num_quantiles; i++) {
+      shard.out() << "\t" << relative_errors[(size_t) (quantiles[i] * (num_trials - 1))];
+    }
+    for (unsigned kappa = 1; kappa <= max_kappa; kappa++) {
+      shard.out() << "\t" << (double) num_covered[kappa - 1] / num_trials;
+    }
+    shard.out() << "\t" << get_estimate.get_mean()
+        << "\t" << get_lower_bound.get_mean()
+        << "\t" << get_upper_bound.get_mean();
+    print_timing_summary(shard.out(), columns, stats_columns);
+    shard.out() << std::endl;
+  };
+
+  if (incremental) {
+    // one stream per trial: the distinct count of a prefix is its length, so the sketch is simply evaluated
+    // whenever the stream reaches a checkpoint
+    const prefix_sweep sweep(shard, lg_min_stream_len, lg_max_stream_len, ppo, [&](size_t stream_length) {
+      return get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
+    });
+    const size_t num_checkpoints = sweep.get_num_checkpoints();
+    if (num_checkpoints == 0) return;
+
+    // results by checkpoint and trial
+    const size_t max_trials = sweep.get_max_trials();
+    std::vector<double> relative_errors(num_checkpoints * max_trials);
+    std::vector<unsigned char> is_covered(num_checkpoints * max_trials * max_kappa);
+    std::vector<uint64_t> num_coupons(num_checkpoints);
+
+    scheduler.run(max_trials, [&](unsigned, size_t trial) {
+      uint64_t counter = derive_seed(seed, 0, trial);
+      cpc_sketch sketch(lg_k);
+      size_t i = 0;
+      for (size_t checkpoint = 0; checkpoint < sweep.get_num_checkpoints(trial); checkpoint++) {
+        const size_t stream_length = sweep.get_stream_length(checkpoint);
+        for (; i < stream_length; i++) {
+          sketch.update(counter);
+          counter += golden64;
+        }
+        relative_errors[checkpoint * max_trials + trial] = sketch.get_estimate() / stream_length - 1;
+        for (unsigned kappa = 1; kappa <= max_kappa; kappa++) {
+          is_covered[(checkpoint * max_trials + trial) * max_kappa + kappa - 1] =
+              sketch.get_lower_bound(kappa) <= stream_length && stream_length <= sketch.get_upper_bound(kappa);
+        }
+        if (trial == 0) num_coupons[checkpoint] = sketch.get_num_coupons();
+      }
+    });
+
+    uint64_t counter = derive_seed(seed, 0, max_trials);
+    cpc_sketch timing_sketch(lg_k);
+    size_t i = 0;
+    for (size_t checkpoint = 0; checkpoint < num_checkpoints; checkpoint++) {
+      const size_t stream_length = sweep.get_stream_length(checkpoint);
+      for (; i < stream_length; i++) {
+        timing_sketch.update(counter);
+        counter += golden64;
+      }
+      const double* errors = &relative_errors[checkpoint * max_trials];
+      const size_t num_trials = sweep.get_num_trials(checkpoint);
+      write_row(stream_length, num_trials, std::vector<double>(errors, errors + num_trials),
+          &is_covered[checkpoint * max_trials * max_kappa], num_coupons[checkpoint], timing_sketch);
+    }
+    return;
+  }
+
+  for (size_t stream_length = 1 << lg_min_stream_len; stream_length <= (1 << lg_max_stream_len); stream_length = pwr_2_law_next(ppo, stream_length)) {
+    if (!shard.should_run(stream_length)) continue;
+
+    const size_t num_trials = get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
+
+    // results are stored by trial index, so they do not depend on the order of execution
+    std::vector<double> relative_errors(num_trials);
+    std::vector<unsigned char> is_covered(num_trials * max_kappa);
+    std::vector<uint64_t> num_coupons(num_trials);
+
+    scheduler.run(num_trials, [&](unsigned, size_t trial) {
+      // distinct values: a sequence of golden ratio increments from a random starting point
+      uint64_t counter = derive_seed(seed, stream_length, trial);
+      cpc_sketch sketch(lg_k);
+      for (size_t i = 0; i < stream_length; i++) {
+        sketch.update(counter);
+        counter += golden64;
+      }
+      relative_errors[trial] = sketch.get_estimate() / stream_length - 1;
+      for (unsigned kappa = 1; kappa <= max_kappa; kappa++) {
+        is_covered[trial * max_kappa + kappa - 1] =
+            sketch.get_lower_bound(kappa) <= stream_length && stream_length <= sketch.get_upper_bound(kappa);
+      }
+      num_coupons[trial] = sketch.get_num_coupons();
+    });
+
+    uint64_t counter = derive_seed(seed, stream_length, num_trials);
+    cpc_sketch timing_sketch(lg_k);
+    for (size_t i = 0; i < stream_length; i++) {
+      timing_sketch.update(counter);
+      counter += golden64;
+    }
+    write_row(stream_length, num_trials, relative_errors, is_covered.data(), num_coupons[0], timing_sketch);
+  }
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef CPC_SKETCH_ACCURACY_PROFILE_H_
+#define CPC_SKETCH_ACCURACY_PROFILE_H_
+
+#include "profile.h"
+
+namespace datasketches {
+
+/*
+ * Distribution of the relative error of the CPC estimate, coverage of the lower and upper bounds,
+ * and latency of the estimate and bound queries, at each stream length of distinct values.
+ * In the incremental mode every trial feeds one stream and is evaluated at all stream lengths,
+ * instead of building a fresh sketch for each of them.
+ */
+class cpc_sketch_accuracy_profile: public profile {
+public:
+  explicit cpc_sketch_accuracy_profile(bool incremental = false);
+  virtual void run(sweep_shard& shard);
+
+private:
+  bool incremental;
+};
+
+} /* namespace datasketches */
+
+#endif /* CPC_SKETCH_ACCURACY_PROFILE_H_ */
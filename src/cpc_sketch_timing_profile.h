@@ -6,11 +6,13 @@
 #ifndef CPC_SKETCH_TIMING_PROFILE_H_
 #define CPC_SKETCH_TIMING_PROFILE_H_
 
+#include "profile.h"
+
 namespace datasketches {
 
-class cpc_sketch_timing_profile {
+class cpc_sketch_timing_profile: public profile {
 public:
-  virtual void run();
+  virtual void run(sweep_shard& shard);
 };
 
 } /* namespace datasketches */
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "cpc_union_timing_profile.h"
+#include "characterization_utils.h"
+#include "timing_core.h"
+#include "counting_allocator.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <cpc_sketch.hpp>
+#include <cpc_union.hpp>
+
+namespace datasketches {
+
+typedef cpc_sketch_alloc<counting_allocator<void>> counted_cpc_sketch;
+typedef cpc_union_alloc<counting_allocator<void>> counted_cpc_union;
+
+void cpc_union_timing_profile::run(sweep_shard& shard) {
+  const size_t lg_min_stream_len(0);
+  const size_t lg_max_stream_len(23);
+  const size_t ppo(16);
+
+  const size_t lg_max_trials(8);
+  const size_t lg_min_trials(4);
+
+  const size_t num_warmup_trials(2);
+
+  const size_t lg_max_num_sketches(10);
+
+  const int lg_k(10);
+
+  // some arbitrary starting value
+  const uint64_t start_value(35538947);
+
+  const uint64_t golden64(0x9e3779b97f4a7c13ULL);  // the golden ratio
+
+  shard.header() << "Stream\tSketches\tFlavor\tTrials\tUnionUpdate\tResult\tDeserUnion\tResultSize\tResultCoupons";
+
+  timing_column union_update("UnionUpdate");
+  timing_column get_result("Result");
+  timing_column deserialize_union("DeserUnion");
+  const std::vector<timing_column*> columns = {&union_update, &get_result, &deserialize_union};
+  print_timing_summary_header(shard.header(), columns);
+  shard.header() << std::endl;
+
+  // disjoint input sketches (as from partitioned data), unions do not modify them,
+  // so they are extended from one point to the next instead of being built again for every point:
+  // item j of sketch i is a bijection of (i, j), multiplying by an odd number is invertible
+  const size_t max_num_sketches(1 << lg_max_num_sketches);
+  std::vector<std::unique_ptr<counted_cpc_sketch>> inputs;
+  for (size_t i = 0; i < max_num_sketches; i++) inputs.emplace_back(new counted_cpc_sketch(lg_k));
+  size_t input_length(0);
+
+  for (size_t stream_length = 1 << lg_min_stream_len; stream_length <= (1 << lg_max_stream_len); stream_length = pwr_2_law_next(ppo, stream_length)) {
+    for (size_t i = 0; i < max_num_sketches; i++) {
+      for (size_t j = input_length; j < stream_length; j++) {
+        inputs[i]->update(start_value + (((uint64_t) i << 32) | j) * golden64);
+      }
+    }
+    input_length = stream_length;
+    if (!shard.should_run(stream_length)) continue;
+
+    std::vector<std::string> serialized_inputs;
+    for (size_t i = 0; i < max_num_sketches; i++) {
+      std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+      inputs[i]->serialize(s);
+      serialized_inputs.push_back(s.str());
+    }
+    const char* flavor = get_cpc_flavor_name(lg_k, inputs[0]->get_num_coupons());
+
+    // all rows of a point are written together, so an interrupted point is computed again on restart
+    std::ostringstream rows;
+    const size_t num_trials = get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
+
+    for (size_t num_sketches = 1; num_sketches <= max_num_sketches; num_sketches *= 4) {
+      size_t result_size_bytes(0);
+      double result_coupons(0);
+
+      for (size_t i = 0; i < num_warmup_trials + num_trials; i++) {
+        if (i == num_warmup_trials) {
+          // discard measurements of the warmup trials
+          for (auto column: columns) column->clear();
+          result_size_bytes = 0;
+          result_coupons = 0;
+        }
+
+        counted_cpc_union u(lg_k);
+        const auto start_update(union_update.start());
+        for (size_t j = 0; j < num_sketches; j++) u.update(*inputs[j]);
+        union_update.stop(start_update, num_sketches);
+
+        const auto start_result(get_result.start());
+        auto result = u.get_result();
+        get_result.stop(start_result);
+
+        counted_cpc_union pipeline_union(lg_k);
+        const auto start_pipeline(deserialize_union.start());
+        for (size_t j = 0; j < num_sketches; j++) {
+          auto sketch = counted_cpc_sketch::deserialize(serialized_inputs[j].data(), serialized_inputs[j].size());
+          pipeline_union.update(*sketch);
+        }
+        deserialize_union.stop(start_pipeline, num_sketches);
+
+        std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+        result->serialize(s);
+        result_size_bytes += s.tellp();
+        result_coupons += result->get_num_coupons();
+      }
+
+      shard.add_row_samples(get_raw_samples(columns));
+      rows << stream_length << "\t"
+          << num_sketches << "\t"
+          << flavor << "\t"
+          << num_trials << "\t"
+          << union_update.get_mean() << "\t"
+          << get_result.get_mean() << "\t"
+          << deserialize_union.get_mean() << "\t"
+          << (double) result_size_bytes / num_trials << "\t"
+          << result_coupons / num_trials;
+      print_timing_summary(rows, columns);
+      rows << std::endl;
+    }
+    shard.out() << rows.str() << std::flush;
+  }
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef CPC_UNION_TIMING_PROFILE_H_
+#define CPC_UNION_TIMING_PROFILE_H_
+
+#include "profile.h"
+
+namespace datasketches {
+
+/*
+ * Cost of rolling up many CPC sketches with cpc_union: per-input union update, result extraction,
+ * and a pipeline that deserializes each input before the union update.
+ * The stream length of the input sketches determines their flavor (sparse, hybrid, pinned, sliding).
+ * Produces a row for each number of input sketches at each stream length.
+ */
+class cpc_union_timing_profile: public profile {
+public:
+  virtual void run(sweep_shard& shard);
+};
+
+} /* namespace datasketches */
+
+#endif /* CPC_UNION_TIMING_PROFILE_H_ */
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "cpu_isolation.h"
+#include "run_metadata.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace datasketches {
+
+std::vector<unsigned> parse_cpu_list(const std::string& list) {
+  std::vector<unsigned> cpus;
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    if (range.empty() || range.find_first_not_of(" \n") == std::string::npos) continue;
+    const char* begin = range.c_str();
+    char* end;
+    const unsigned long first = strtoul(begin, &end, 10);
+    unsigned long last = first;
+    if (end == begin) throw std::invalid_argument("invalid CPU list " + list);
+    if (*end == '-') {
+      const char* second = end + 1;
+      last = strtoul(second, &end, 10);
+      if (end == second || last < first) throw std::invalid_argument("invalid CPU list " + list);
+    }
+    if (*end != 0 && *end != '\n') throw std::invalid_argument("invalid CPU list " + list);
+    for (unsigned long cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+static std::string format_cpu_list(const std::vector<unsigned>& cpus) {
+  std::ostringstream os;
+  for (size_t i = 0; i < cpus.size(); i++) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+    if (i > 0) os << ",";
+    os << cpus[i];
+    if (j > i) os << "-" << cpus[j];
+    i = j;
+  }
+  return os.str();
+}
+
+static std::vector<unsigned>& get_process_cpus() {
+  static std::vector<unsigned> cpus = []() {
+    const char* env = getenv("CHARACTERIZATION_CPUS");
+    return env != nullptr ? parse_cpu_list(env) : std::vector<unsigned>();
+  }();
+  return cpus;
+}
+
+const std::vector<unsigned>& get_pinned_cpus() {
+  return get_process_cpus();
+}
+
+void select_shard_cpus(unsigned shard_index, unsigned num_shards) {
+  std::vector<unsigned>& cpus = get_process_cpus();
+  const size_t n = cpus.size();
+  if (n == 0) return;
+  if (n < num_shards) {
+    cpus = {cpus[shard_index % n]};
+  } else {
+    cpus = std::vector<unsigned>(cpus.begin() + shard_index * n / num_shards, cpus.begin() + (shard_index + 1) * n / num_shards);
+  }
+}
+
+// first line of a sysfs file, empty if it does not exist
+static std::string read_sysfs(const std::string& path) {
+  std::ifstream is(path);
+  std::string line;
+  std::getline(is, line);
+  return line;
+}
+
+static std::string get_cpu_path(unsigned cpu, const char* file) {
+  return "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/" + file;
+}
+
+// NUMA node of every CPU, empty if the system has no NUMA information
+static std::vector<std::pair<unsigned, unsigned>> get_numa_nodes() {
+  std::vector<std::pair<unsigned, unsigned>> cpu_nodes;
+#ifdef __linux__
+  DIR* dir = opendir("/sys/devices/system/node");
+  if (dir == nullptr) return cpu_nodes;
+  while (const dirent* entry = readdir(dir)) {
+    unsigned node;
+    char rest;
+    if (sscanf(entry->d_name, "node%u%c", &node, &rest) != 1) continue;
+    const std::string list = read_sysfs("/sys/devices/system/node/" + std::string(entry->d_name) + "/cpulist");
+    try {
+      for (unsigned cpu: parse_cpu_list(list)) cpu_nodes.push_back(std::make_pair(cpu, node));
+    } catch (std::invalid_argument&) {}
+  }
+  closedir(dir);
+#endif
+  return cpu_nodes;
+}
+
+static std::vector<unsigned> get_numa_nodes_of(const std::vector<unsigned>& cpus) {
+  std::set<unsigned> nodes;
+  for (const auto& cpu_node: get_numa_nodes()) {
+    if (std::find(cpus.begin(), cpus.end(), cpu_node.first) != cpus.end()) nodes.insert(cpu_node.second);
+  }
+  return std::vector<unsigned>(nodes.begin(), nodes.end());
+}
+
+void pin_thread(unsigned index) {
+  const std::vector<unsigned>& cpus = get_pinned_cpus();
+  if (cpus.empty()) return;
+#ifdef __linux__
+  const unsigned cpu = cpus[index % cpus.size()];
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  // pid 0 is the calling thread
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    throw std::runtime_error("cannot pin to CPU " + std::to_string(cpu) + ": " + strerror(errno));
+  }
+#endif
+}
+
+void bind_memory_to_pinned_cpus() {
+  const std::vector<unsigned>& cpus = get_pinned_cpus();
+  if (cpus.empty()) return;
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+  const std::vector<unsigned> nodes = get_numa_nodes_of(cpus);
+  if (nodes.empty()) return; // no NUMA
+  const int mpol_bind = 2; // MPOL_BIND from numaif.h, to not depend on libnuma
+  const unsigned bits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(nodes.back() / bits + 1);
+  for (unsigned node: nodes) mask[node / bits] |= 1UL << (node % bits);
+  if (syscall(SYS_set_mempolicy, mpol_bind, mask.data(), mask.size() * bits + 1) != 0) {
+    throw std::runtime_error("cannot bind memory to NUMA nodes of CPUs " + format_cpu_list(cpus) + ": " + strerror(errno));
+  }
+#endif
+}
+
+static std::vector<unsigned> get_online_cpus() {
+  const std::string online = read_sysfs("/sys/devices/system/cpu/online");
+  if (!online.empty()) {
+    try {
+      return parse_cpu_list(online);
+    } catch (std::invalid_argument&) {}
+  }
+  std::vector<unsigned> cpus(std::max(1u, std::thread::hardware_concurrency()));
+  for (unsigned i = 0; i < cpus.size(); i++) cpus[i] = i;
+  return cpus;
+}
+
+static std::string get_turbo() {
+  const std::string no_turbo = read_sysfs("/sys/devices/system/cpu/intel_pstate/no_turbo");
+  if (no_turbo == "0") return "on";
+  if (no_turbo == "1") return "off";
+  const std::string boost = read_sysfs("/sys/devices/system/cpu/cpufreq/boost");
+  if (boost == "1") return "on";
+  if (boost == "0") return "off";
+  return "unknown";
+}
+
+cpu_state cpu_state::detect() {
+  cpu_state state;
+  state.cpus = get_pinned_cpus();
+  const std::vector<unsigned> used = state.cpus.empty() ? get_online_cpus() : state.cpus;
+  state.numa_nodes = get_numa_nodes_of(used);
+  const std::string used_list = format_cpu_list(used);
+
+  if (state.cpus.empty()) state.warnings.push_back("threads are not pinned to CPUs (--cpus)");
+  if (state.numa_nodes.size() > 1) {
+    state.warnings.push_back("CPUs " + used_list + " span " + std::to_string(state.numa_nodes.size()) + " NUMA nodes");
+  }
+
+  std::set<std::string> governors;
+  std::set<std::string> other_governors;
+  state.min_frequency_khz = 0;
+  state.max_frequency_khz = 0;
+  for (unsigned cpu: used) {
+    const std::string governor = read_sysfs(get_cpu_path(cpu, "cpufreq/scaling_governor"));
+    if (governor.empty()) continue;
+    governors.insert(governor);
+    if (governor != "performance") other_governors.insert(governor);
+    const uint64_t min_frequency = strtoull(read_sysfs(get_cpu_path(cpu, "cpufreq/scaling_min_freq")).c_str(), nullptr, 10);
+    const uint64_t max_frequency = strtoull(read_sysfs(get_cpu_path(cpu, "cpufreq/scaling_max_freq")).c_str(), nullptr, 10);
+    if (min_frequency > 0 && (state.min_frequency_khz == 0 || min_frequency < state.min_frequency_khz)) {
+      state.min_frequency_khz = min_frequency;
+    }
+    state.max_frequency_khz = std::max(state.max_frequency_khz, max_frequency);
+  }
+  state.governor = governors.empty() ? "unknown" : governors.size() > 1 ? "mixed" : *governors.begin();
+  for (const auto& governor: other_governors) {
+    state.warnings.push_back("CPUs " + used_list + " use the " + governor + " governor, not performance");
+  }
+  if (state.min_frequency_khz > 0 && state.min_frequency_khz < state.max_frequency_khz) {
+    state.warnings.push_back("frequency scaling between " + std::to_string(state.min_frequency_khz / 1000)
+        + " and " + std::to_string(state.max_frequency_khz / 1000) + " MHz (scaling_min_freq below scaling_max_freq)");
+  }
+
+  state.turbo = get_turbo();
+  if (state.turbo == "on") state.warnings.push_back("turbo boost is on");
+
+  const std::string smt_active = read_sysfs("/sys/devices/system/cpu/smt/active");
+  state.smt = smt_active == "1" ? "on" : smt_active == "0" ? "off" : "unknown";
+  if (state.cpus.empty()) {
+    if (state.smt == "on") state.warnings.push_back("SMT is on");
+  } else {
+    // a busy sibling hyperthread shares the core of a pinned CPU
+    for (unsigned cpu: state.cpus) {
+      std::vector<unsigned> siblings;
+      try {
+        siblings = parse_cpu_list(read_sysfs(get_cpu_path(cpu, "topology/thread_siblings_list")));
+      } catch (std::invalid_argument&) {}
+      for (unsigned sibling: siblings) {
+        if (sibling == cpu) continue;
+        const bool pinned = std::find(state.cpus.begin(), state.cpus.end(), sibling) != state.cpus.end();
+        if (pinned && sibling < cpu) continue; // reported with the other one
+        state.warnings.push_back("CPU " + std::to_string(cpu) + " shares a core with " + (pinned ? "pinned " : "online ")
+            + "CPU " + std::to_string(sibling));
+      }
+    }
+  }
+  return state;
+}
+
+static void write_json_array(std::ostream& os, const std::vector<unsigned>& values) {
+  os << "[";
+  for (size_t i = 0; i < values.size(); i++) os << (i > 0 ? ", " : "") << values[i];
+  os << "]";
+}
+
+void cpu_state::write_json(std::ostream& os) const {
+  os << "{\"cpus\": ";
+  write_json_array(os, cpus);
+  os << ", \"numa_nodes\": ";
+  write_json_array(os, numa_nodes);
+  os << ", \"governor\": ";
+  write_json_string(os, governor);
+  os << ", \"min_frequency_khz\": " << min_frequency_khz
+      << ", \"max_frequency_khz\": " << max_frequency_khz << ", \"turbo\": ";
+  write_json_string(os, turbo);
+  os << ", \"smt\": ";
+  write_json_string(os, smt);
+  os << ", \"warnings\": [";
+  for (size_t i = 0; i < warnings.size(); i++) {
+    if (i > 0) os << ", ";
+    write_json_string(os, warnings[i]);
+  }
+  os << "]}";
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef CPU_ISOLATION_H_
+#define CPU_ISOLATION_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace datasketches {
+
+/*
+ * Pinning of the benchmark threads to chosen CPUs and checks of what else can move the timings.
+ * The CPUs come from the CHARACTERIZATION_CPUS environment variable (set by --cpus), a list like "2-5,8",
+ * so that shard processes inherit them. The main thread and worker i of a pool run on the i-th CPU
+ * of the list modulo its size, and memory is bound to the NUMA nodes of these CPUs.
+ * Shard processes that run at the same time each take their own part of the list.
+ * Linux only, elsewhere nothing is pinned and the state is unknown.
+ */
+
+// parses a sysfs style CPU list such as "0-3,8", throws std::invalid_argument
+std::vector<unsigned> parse_cpu_list(const std::string& list);
+
+// the CPUs to run on, empty if the threads are not pinned
+const std::vector<unsigned>& get_pinned_cpus();
+
+// restricts the CPUs of this process to the part of the list for the given shard of num_shards,
+// with fewer CPUs than shards each shard gets one CPU, shared round-robin
+void select_shard_cpus(unsigned shard_index, unsigned num_shards);
+
+// pins the calling thread to the CPU for the given thread index, does nothing if not pinned
+void pin_thread(unsigned index);
+
+// restricts allocations to the NUMA nodes of the pinned CPUs, for the calling thread and the threads it creates
+void bind_memory_to_pinned_cpus();
+
+/*
+ * Frequency scaling, SMT and the governor of the CPUs that run the benchmark (the pinned CPUs or all online CPUs),
+ * read from /sys. Anything that can make the timings unstable is described in warnings.
+ */
+struct cpu_state {
+  std::vector<unsigned> cpus; // pinned, empty if not pinned
+  std::vector<unsigned> numa_nodes; // of the CPUs used
+  std::string governor; // "unknown" if there is no cpufreq, "mixed" if the CPUs differ
+  uint64_t min_frequency_khz; // lowest scaling_min_freq of the CPUs used, 0 if unknown
+  uint64_t max_frequency_khz; // highest scaling_max_freq of the CPUs used, 0 if unknown
+  std::string turbo; // "on", "off" or "unknown"
+  std::string smt; // "on", "off" or "unknown"
+  std::vector<std::string> warnings;
+
+  static cpu_state detect();
+
+  // JSON object
+  void write_json(std::ostream& os) const;
+};
+
+} /* namespace datasketches */
+
+#endif /* CPU_ISOLATION_H_ */
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "dataset_cache.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace datasketches {
+
+static const char MAGIC[8] = {'D', 'S', 'C', 'H', 'D', 'A', 'T', 'A'};
+
+static std::runtime_error system_error(const std::string& message, const std::string& path) {
+  return std::runtime_error(message + " " + path + ": " + strerror(errno));
+}
+
+mapped_file::mapped_file(const std::string& path): ptr(nullptr), size_bytes(0) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) throw system_error("cannot open", path);
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    close(fd);
+    throw system_error("cannot stat", path);
+  }
+  size_bytes = st.st_size;
+  if (size_bytes > 0) {
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE; // reads the file and maps all pages now rather than on first touch in a timed region
+#endif
+    ptr = mmap(nullptr, size_bytes, PROT_READ, flags, fd, 0);
+    if (ptr == MAP_FAILED) {
+      close(fd);
+      throw system_error("cannot map", path);
+    }
+  }
+  close(fd); // the mapping stays valid
+}
+
+mapped_file::mapped_file(mapped_file&& other): ptr(other.ptr), size_bytes(other.size_bytes) {
+  other.ptr = nullptr;
+  other.size_bytes = 0;
+}
+
+mapped_file::~mapped_file() {
+  if (ptr != nullptr) munmap(ptr, size_bytes);
+}
+
+dataset_cache::dataset_cache() {
+  const char* env = getenv("CHARACTERIZATION_DATASET_CACHE");
+  directory = env != nullptr ? env : "dataset_cache";
+}
+
+dataset_cache::dataset_cache(const std::string& directory): directory(directory) {}
+
+mapped_file dataset_cache::get_file(const std::string& key, size_t item_size, size_t num_items, const std::function<void(void*, size_t)>& generate) {
+  const std::string path = directory + "/" + key + ".bin";
+  if (access(path.c_str(), R_OK) == 0) {
+    mapped_file file(path);
+    if (is_valid(file, item_size, num_items)) return file;
+  }
+  create_file(path, item_size, num_items, generate);
+  mapped_file file(path);
+  if (!is_valid(file, item_size, num_items)) throw std::runtime_error("invalid dataset " + path);
+  return file;
+}
+
+// generates directly into a mapping of a temporary file, which is renamed when complete,
+// so concurrent processes never see a partially written dataset
+void dataset_cache::create_file(const std::string& path, size_t item_size, size_t num_items, const std::function<void(void*, size_t)>& generate) {
+  if (mkdir(directory.c_str(), 0755) == -1 && errno != EEXIST) throw system_error("cannot create directory", directory);
+  const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+  const int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) throw system_error("cannot create", tmp_path);
+  const size_t size_bytes = HEADER_SIZE_BYTES + item_size * num_items;
+  if (ftruncate(fd, size_bytes) == -1) {
+    close(fd);
+    throw system_error("cannot resize", tmp_path);
+  }
+  void* ptr = mmap(nullptr, size_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ptr == MAP_FAILED) throw system_error("cannot map", tmp_path);
+
+  char* header = static_cast<char*>(ptr);
+  const uint32_t version = FORMAT_VERSION;
+  const uint32_t item_size32 = item_size;
+  const uint64_t num_items64 = num_items;
+  memcpy(header, MAGIC, sizeof(MAGIC));
+  memcpy(header + 8, &version, sizeof(version));
+  memcpy(header + 12, &item_size32, sizeof(item_size32));
+  memcpy(header + 16, &num_items64, sizeof(num_items64));
+  try {
+    generate(header + HEADER_SIZE_BYTES, num_items);
+  } catch (...) {
+    munmap(ptr, size_bytes);
+    unlink(tmp_path.c_str());
+    throw;
+  }
+  munmap(ptr, size_bytes);
+  if (rename(tmp_path.c_str(), path.c_str()) == -1) throw system_error("cannot rename", tmp_path);
+}
+
+bool dataset_cache::read_header(const mapped_file& file, dataset_header& header) {
+  if (file.size() < HEADER_SIZE_BYTES) return false;
+  const char* data = static_cast<const char*>(file.data());
+  if (memcmp(data, MAGIC, sizeof(MAGIC)) != 0) return false;
+  memcpy(&header.version, data + 8, sizeof(header.version));
+  memcpy(&header.item_size, data + 12, sizeof(header.item_size));
+  memcpy(&header.num_items, data + 16, sizeof(header.num_items));
+  return true;
+}
+
+bool dataset_cache::is_valid(const mapped_file& file, size_t item_size, size_t num_items) {
+  dataset_header header;
+  return read_header(file, header)
+      && header.version == FORMAT_VERSION
+      && header.item_size == item_size
+      && header.num_items == num_items
+      && file.size() == HEADER_SIZE_BYTES + item_size * num_items;
+}
+
+} /* namespace datasketches */
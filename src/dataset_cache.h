@@ -0,0 +1,112 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef DATASET_CACHE_H_
+#define DATASET_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <functional>
+
+namespace datasketches {
+
+/*
+ * Read-only memory mapping of a whole file, unmapped on destruction.
+ * All pages are read and mapped on construction, so that reading them later does not fault.
+ */
+class mapped_file {
+public:
+  explicit mapped_file(const std::string& path);
+  mapped_file(mapped_file&& other);
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+  ~mapped_file();
+
+  const void* data() const { return ptr; }
+  size_t size() const { return size_bytes; }
+
+private:
+  void* ptr;
+  size_t size_bytes;
+};
+
+/*
+ * Items of a cached dataset, read directly from the mapped file
+ */
+template<typename T>
+class mapped_dataset {
+public:
+  explicit mapped_dataset(mapped_file&& file, size_t offset_bytes, size_t num_items):
+    file(std::move(file)), items(reinterpret_cast<const T*>(static_cast<const char*>(this->file.data()) + offset_bytes)), num_items(num_items) {}
+
+  const T* data() const { return items; }
+  size_t size() const { return num_items; }
+  const T& operator[](size_t i) const { return items[i]; }
+
+private:
+  mapped_file file;
+  const T* items;
+  size_t num_items;
+};
+
+// the fields of the header of a dataset file
+struct dataset_header {
+  uint32_t version;
+  uint32_t item_size;
+  uint64_t num_items;
+};
+
+/*
+ * Generated input streams stored on disk, so that the same stream does not need to be generated again
+ * in subsequent trials and runs. To use identical inputs on another machine, copy the file there:
+ * the standard distributions used by the generators are implementation-defined, so generating
+ * with the same seed elsewhere (another standard library) may give a different stream.
+ * A dataset is identified by a key that must include the distribution, its parameters and the seed,
+ * for example "zipf_8192_0.7_seed1".
+ *
+ * File format (native byte order, the file is not meant to be portable across architectures):
+ *   8 bytes: magic "DSCHDATA"
+ *   4 bytes: format version
+ *   4 bytes: item size in bytes
+ *   8 bytes: number of items
+ *   items as a flat array
+ *
+ * The directory defaults to the value of the CHARACTERIZATION_DATASET_CACHE environment variable
+ * or "dataset_cache" in the working directory.
+ */
+class dataset_cache {
+public:
+  dataset_cache();
+  explicit dataset_cache(const std::string& directory);
+
+  // maps the dataset, calling generate(items, num_items) to create it first if needed
+  template<typename T>
+  mapped_dataset<T> get(const std::string& key, size_t num_items, const std::function<void(T*, size_t)>& generate) {
+    auto file = get_file(key, sizeof(T), num_items, [&generate](void* items, size_t num_items) {
+      generate(static_cast<T*>(items), num_items);
+    });
+    return mapped_dataset<T>(std::move(file), HEADER_SIZE_BYTES, num_items);
+  }
+
+  static const size_t HEADER_SIZE_BYTES = 24;
+  static const uint32_t FORMAT_VERSION = 1;
+
+  // reads the header, returns false if the file does not start with the magic
+  static bool read_header(const mapped_file& file, dataset_header& header);
+
+  // true if the file is a dataset of the current version with exactly num_items items of item_size bytes
+  static bool is_valid(const mapped_file& file, size_t item_size, size_t num_items);
+
+private:
+  std::string directory;
+
+  mapped_file get_file(const std::string& key, size_t item_size, size_t num_items, const std::function<void(void*, size_t)>& generate);
+  void create_file(const std::string& path, size_t item_size, size_t num_items, const std::function<void(void*, size_t)>& generate);
+};
+
+} /* namespace datasketches */
+
+#endif /* DATASET_CACHE_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef DISTINCT_COUNT_TIMING_H_
+#define DISTINCT_COUNT_TIMING_H_
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <string>
+
+#include "trace_input.h"
+
+namespace datasketches {
+
+/*
+ * Common part of the timing_profile traits of the distinct count sketches.
+ * The input is a sequence of distinct values that continues across trials, so every trial gets new values,
+ * or windows of the trace named by CHARACTERIZATION_TRACE if it is set.
+ */
+class distinct_count_timing_traits {
+public:
+  typedef uint64_t item_type;
+  static const size_t lg_min_trials = 8;
+  static const size_t lg_max_trials = 16;
+
+  // some arbitrary starting value
+  distinct_count_timing_traits(): counter(35538947) {
+    const std::string path = get_trace_path();
+    if (!path.empty()) trace.reset(new trace_file<uint64_t>(path));
+  }
+
+  const uint64_t* get_items(size_t stream_length, size_t trial) {
+    if (trace) return get_window(trace->data(), trace->size(), stream_length, trial, items);
+    const uint64_t golden64(0x9e3779b97f4a7c13ULL);  // the golden ratio
+    items.resize(stream_length);
+    for (size_t i = 0; i < stream_length; i++) {
+      items[i] = counter;
+      counter += golden64;
+    }
+    return items.data();
+  }
+
+private:
+  uint64_t counter;
+  std::vector<uint64_t> items;
+  std::unique_ptr<trace_file<uint64_t>> trace;
+};
+
+} /* namespace datasketches */
+
+#endif /* DISTINCT_COUNT_TIMING_H_ */
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "exact_frequencies.h"
+
+#include <cstdint>
+#include <algorithm>
+
+namespace datasketches {
+
+static const size_t MIN_SPARSE_SLOTS = 1 << 10;
+
+// from the finalizer of MurmurHash3
+static inline size_t hash_value(unsigned value) {
+  uint64_t h = value;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+exact_frequencies::exact_frequencies(unsigned dense_limit):
+dense_limit(dense_limit),
+dense_counts(dense_limit, 0),
+sparse_keys(MIN_SPARSE_SLOTS),
+sparse_counts(MIN_SPARSE_SLOTS, 0),
+num_sparse(0)
+{}
+
+void exact_frequencies::clear() {
+  for (unsigned value: distinct_values) {
+    if (value < dense_limit) dense_counts[value] = 0;
+  }
+  // emptying slots one by one would break the probe sequences of the remaining ones
+  if (num_sparse > 0) std::fill(sparse_counts.begin(), sparse_counts.end(), 0);
+  num_sparse = 0;
+  distinct_values.clear();
+}
+
+void exact_frequencies::add(const unsigned* values, size_t num_values) {
+  for (size_t i = 0; i < num_values; i++) {
+    const unsigned value = values[i];
+    if (value < dense_limit) {
+      if (dense_counts[value]++ == 0) distinct_values.push_back(value);
+    } else {
+      add_sparse(value);
+    }
+  }
+}
+
+unsigned exact_frequencies::get(unsigned value) const {
+  if (value < dense_limit) return dense_counts[value];
+  return sparse_counts[find_slot(value)];
+}
+
+unsigned exact_frequencies::count_above(unsigned threshold) const {
+  unsigned count = 0;
+  for (unsigned value: distinct_values) count += get(value) > threshold;
+  return count;
+}
+
+// slot of the value, or the empty slot where it would go
+size_t exact_frequencies::find_slot(unsigned value) const {
+  const size_t mask = sparse_keys.size() - 1;
+  size_t slot = hash_value(value) & mask;
+  while (sparse_counts[slot] != 0 && sparse_keys[slot] != value) slot = (slot + 1) & mask;
+  return slot;
+}
+
+void exact_frequencies::add_sparse(unsigned value) {
+  size_t slot = find_slot(value);
+  if (sparse_counts[slot] == 0) {
+    if (2 * (num_sparse + 1) > sparse_keys.size()) {
+      grow_sparse();
+      slot = find_slot(value);
+    }
+    sparse_keys[slot] = value;
+    num_sparse++;
+    distinct_values.push_back(value);
+  }
+  sparse_counts[slot]++;
+}
+
+void exact_frequencies::grow_sparse() {
+  std::vector<unsigned> old_keys(sparse_keys.size() * 2);
+  std::vector<unsigned> old_counts(sparse_counts.size() * 2, 0);
+  old_keys.swap(sparse_keys);
+  old_counts.swap(sparse_counts);
+  for (size_t i = 0; i < old_keys.size(); i++) {
+    if (old_counts[i] != 0) {
+      const size_t slot = find_slot(old_keys[i]);
+      sparse_keys[slot] = old_keys[i];
+      sparse_counts[slot] = old_counts[i];
+    }
+  }
+}
+
+} /* namespace datasketches */
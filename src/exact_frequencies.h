@@ -0,0 +1,49 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef EXACT_FREQUENCIES_H_
+#define EXACT_FREQUENCIES_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace datasketches {
+
+/*
+ * Exact frequencies of a stream of unsigned values (ground truth for frequent items), reused across trials.
+ * Values below dense_limit are counted in a flat array, which covers bounded domains such as Zipf samples.
+ * Other values go to an open-addressing table with linear probing, where an empty slot has a count of zero.
+ * The distinct values are recorded as they appear, so clearing the array costs as much as the last stream touched,
+ * not the size of the domain. The table is only cleared if it was used.
+ */
+class exact_frequencies {
+public:
+  explicit exact_frequencies(unsigned dense_limit);
+
+  void clear();
+  void add(const unsigned* values, size_t num_values);
+  unsigned get(unsigned value) const;
+
+  // number of distinct values with frequency above the threshold
+  unsigned count_above(unsigned threshold) const;
+
+  const std::vector<unsigned>& get_distinct_values() const { return distinct_values; }
+
+private:
+  unsigned dense_limit;
+  std::vector<unsigned> dense_counts;
+  std::vector<unsigned> sparse_keys;
+  std::vector<unsigned> sparse_counts;
+  size_t num_sparse;
+  std::vector<unsigned> distinct_values;
+
+  size_t find_slot(unsigned value) const;
+  void add_sparse(unsigned value);
+  void grow_sparse();
+};
+
+} /* namespace datasketches */
+
+#endif /* EXACT_FREQUENCIES_H_ */
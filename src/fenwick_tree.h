@@ -0,0 +1,44 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef FENWICK_TREE_H_
+#define FENWICK_TREE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace datasketches {
+
+/*
+ * Counts of values in [0, size) with prefix sums in O(log size) (binary indexed tree).
+ * Used as the ground truth of ranks in a growing stream: the true rank of a value is the number of values
+ * added so far that are less than it.
+ */
+class fenwick_tree {
+public:
+  explicit fenwick_tree(size_t size): counts(size + 1, 0) {}
+
+  void clear() { std::fill(counts.begin(), counts.end(), 0); }
+
+  void add(size_t value) {
+    for (size_t i = value + 1; i < counts.size(); i += i & (~i + 1)) counts[i]++;
+  }
+
+  // number of values added so far that are less than the given one
+  uint64_t count_less(size_t value) const {
+    uint64_t count = 0;
+    for (size_t i = std::min(value, counts.size() - 1); i > 0; i -= i & (~i + 1)) count += counts[i];
+    return count;
+  }
+
+private:
+  std::vector<uint32_t> counts;
+};
+
+} /* namespace datasketches */
+
+#endif /* FENWICK_TREE_H_ */
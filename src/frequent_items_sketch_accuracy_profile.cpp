@@ -6,20 +6,109 @@
 #include "frequent_items_sketch_accuracy_profile.h"
 #include "characterization_utils.h"
 #include "zipf_distribution.h"
+#include "trial_scheduler.h"
+#include "exact_frequencies.h"
+#include "prefix_sweep.h"
 
 #include <iostream>
-#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <random>
 
 #include <frequent_items_sketch.hpp>
 
 namespace datasketches {
 
-void frequent_items_sketch_accuracy_profile::run() {
-  const unsigned lg_num_sketches = 4; // merge if > 0 (more than 1 sketch)
+// boundaries of the parts of a stream: equal parts, or parts cut at random points
+static void partition_stream(size_t* bounds, size_t stream_length, unsigned num_parts, bool uneven, uint64_t seed) {
+  bounds[0] = 0;
+  bounds[num_parts] = stream_length;
+  if (uneven) {
+    std::default_random_engine generator(seed);
+    std::uniform_int_distribution<size_t> distribution(0, stream_length);
+    for (unsigned i = 1; i < num_parts; i++) bounds[i] = distribution(generator);
+    std::sort(bounds + 1, bounds + num_parts);
+  } else {
+    for (unsigned i = 1; i < num_parts; i++) bounds[i] = stream_length * i / num_parts;
+  }
+}
+
+// sums of the checks over the trials of a stream length
+struct accuracy_counts {
+  unsigned num_items;
+  unsigned max_error;
+  unsigned num_error_1;
+  unsigned num_error_2;
+  unsigned extra_items;
+  unsigned num_error_3;
+  accuracy_counts(): num_items(0), max_error(0), num_error_1(0), num_error_2(0), extra_items(0), num_error_3(0) {}
+  void add(const accuracy_counts& other) {
+    num_items += other.num_items;
+    max_error += other.max_error;
+    num_error_1 += other.num_error_1;
+    num_error_2 += other.num_error_2;
+    extra_items += other.extra_items;
+    num_error_3 += other.num_error_3;
+  }
+};
+
+// checks, all in one pass over the items of the sketch:
+// using the a priori threshold (conservative) and using the actual max error (the default)
+// NO_FALSE_POSITIVES returns the items with lower bound above the threshold,
+// NO_FALSE_NEGATIVES returns the items with upper bound above the threshold
+static void check_sketch(const frequent_items_sketch<unsigned>& sketch, const exact_frequencies& truth, unsigned threshold,
+    accuracy_counts& counts) {
+  counts.num_items += sketch.get_num_active_items();
+  counts.max_error += sketch.get_maximum_error();
+  const unsigned num_frequent = truth.count_above(threshold);
+  const uint64_t max_error = sketch.get_maximum_error();
+  unsigned num_conservative_found = 0;
+  unsigned num_found = 0;
+  for (auto& it: sketch.get_frequent_items(frequent_items_error_type::NO_FALSE_NEGATIVES, 0)) {
+    const bool is_frequent = truth.get(it.get_item()) > threshold;
+    if (is_frequent) {
+      // the exact solution must be a subset of NO_FALSE_NEGATIVES (all frequent items above threshold must be present)
+      num_conservative_found += it.get_upper_bound() > threshold;
+      num_found += it.get_upper_bound() > max_error;
+    } else {
+      // NO_FALSE_POSITIVES must be a subset of the exact solution (only frequent items above threshold)
+      counts.num_error_1 += it.get_lower_bound() > threshold;
+      // this is expected to find more items compared to using conservative threshold
+      counts.extra_items += it.get_lower_bound() > max_error;
+    }
+  }
+  counts.num_error_2 += num_frequent - num_conservative_found;
+  counts.num_error_3 += num_frequent - num_found;
+}
+
+static void write_row(std::ostream& os, size_t stream_length, size_t num_trials, unsigned threshold, const accuracy_counts& counts) {
+  os << stream_length
+      << "\t" << num_trials
+      << "\t" << (double) counts.num_items / num_trials
+      << "\t" << threshold
+      << "\t" << (double) counts.max_error / num_trials
+      << "\t" << (double) counts.num_error_1 / num_trials
+      << "\t" << (double) counts.num_error_2 / num_trials
+      << "\t" << (double) counts.extra_items / num_trials
+      << "\t" << (double) counts.num_error_3 / num_trials
+      << std::endl;
+}
+
+frequent_items_sketch_accuracy_profile::frequent_items_sketch_accuracy_profile(bool incremental): incremental(incremental) {}
+
+void frequent_items_sketch_accuracy_profile::run(sweep_shard& shard) {
+  if (incremental) {
+    run_incremental(shard);
+    return;
+  }
+
+  const unsigned num_sketches = 16; // merge if > 1, any number of partitions
+  const bool uneven_partitions = true; // partitions cut at random points instead of equal ones
 
   const unsigned lg_min_stream_len = 5;
   const unsigned lg_max_stream_len = 23;
-  const unsigned ppo = (lg_num_sketches > 0) ? 1 : 16; // simple partitioning for merging relies on powers of 2
+  const unsigned ppo = 16;
 
   const unsigned lg_max_trials = 18;
   const unsigned lg_min_trials = 10;
@@ -29,116 +118,171 @@ void frequent_items_sketch_accuracy_profile::run() {
   const unsigned zipf_lg_range = 13; // range: 8K values for 1K sketch
   const double zipf_exponent = 0.7;
 
-  zipf_distribution zipf(1 << zipf_lg_range, zipf_exponent);
+  // trials are processed in blocks, these bound the values and partial sketches held at once
+  const size_t max_block_values = 1 << 24;
+  const size_t max_block_sketches = 1 << 14;
+
+  // trials are seeded from this, so the output does not depend on the number of threads
+  const uint64_t seed(get_run_seed());
+
+  // each worker owns its generator, ground truth and counters
+  struct worker_state {
+    zipf_distribution zipf;
+    accuracy_counts counts;
+    exact_frequencies truth;
+    worker_state(zipf_distribution&& zipf, unsigned max_value):
+      zipf(std::move(zipf)), truth(max_value + 1) {}
+  };
+  trial_scheduler scheduler;
+  std::vector<worker_state> workers;
+  for (unsigned i = 0; i < scheduler.get_num_threads(); i++) {
+    workers.emplace_back(zipf_distribution(1 << zipf_lg_range, zipf_exponent, seed, zipf_distribution::ALIAS_TABLE), 1 << zipf_lg_range);
+  }
 
-  size_t stream_length = 1 << lg_min_stream_len;
-  while (stream_length <= 1 << lg_max_stream_len) {
-    unsigned num_items = 0;
-    unsigned max_error = 0;
-    unsigned num_error_1 = 0;
-    unsigned num_error_2 = 0;
-    unsigned extra_items = 0;
-    unsigned num_error_3 = 0;
+  for (size_t stream_length = 1 << lg_min_stream_len; stream_length <= 1 << lg_max_stream_len; stream_length = pwr_2_law_next(ppo, stream_length)) {
+    if (!shard.should_run(stream_length)) continue;
+
+    for (auto& worker: workers) worker.counts = accuracy_counts();
 
     const size_t num_trials = get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
 
     // trust sketch to compute epsilon
     unsigned threshold = frequent_items_sketch<unsigned, unsigned>::get_epsilon(lg_max_sketch_size) * stream_length;
 
-    unsigned* values = new unsigned[stream_length];
+    const size_t block_trials = std::min(num_trials,
+        std::max<size_t>(1, std::min(max_block_values / stream_length, max_block_sketches / num_sketches)));
+    std::vector<unsigned> values(block_trials * stream_length);
+    std::vector<size_t> bounds(block_trials * (num_sketches + 1));
+    std::vector<std::unique_ptr<frequent_items_sketch<unsigned>>> partial_sketches(block_trials * num_sketches);
 
-    for (size_t i = 0; i < num_trials; i++) {
-      // prepare values for this trial
-      for (size_t j = 0; j < stream_length; j++) {
-        values[j] = zipf.sample();
+    for (size_t first_trial = 0; first_trial < num_trials; first_trial += block_trials) {
+      const size_t num_block_trials = std::min(block_trials, num_trials - first_trial);
+      for (size_t t = 0; t < num_block_trials; t++) {
+        partition_stream(&bounds[t * (num_sketches + 1)], stream_length, num_sketches, uneven_partitions,
+            derive_seed(~seed, stream_length, first_trial + t));
       }
 
-      frequent_items_sketch<unsigned> sketch(lg_max_sketch_size);
-      if (lg_num_sketches == 0) {
-        for (size_t j = 0; j < stream_length; j++) {
-          sketch.update(values[j]);
+      // the partial sketches of all trials in the block are built concurrently, each from its own part of the stream
+      // each part is drawn with its own seed, so the parts do not depend on which worker produced them
+      scheduler.run(num_block_trials * num_sketches, [&](unsigned worker_index, size_t task) {
+        worker_state& worker = workers[worker_index];
+        const size_t t = task / num_sketches;
+        const size_t part = task % num_sketches;
+        const size_t* trial_bounds = &bounds[t * (num_sketches + 1)];
+        unsigned* part_values = &values[t * stream_length + trial_bounds[part]];
+        const size_t part_length = trial_bounds[part + 1] - trial_bounds[part];
+
+        worker.zipf.seed(derive_seed(seed, stream_length, (first_trial + t) * num_sketches + part));
+        worker.zipf.sample_n(part_values, part_length);
+
+        partial_sketches[task].reset(new frequent_items_sketch<unsigned>(lg_max_sketch_size));
+        for (size_t j = 0; j < part_length; j++) {
+          partial_sketches[task]->update(part_values[j]);
         }
-      } else {
-        // this partitioning relies on stream length being power of 2, so ppo must be 1
-        const unsigned substream_length = stream_length / (1 << lg_num_sketches);
-        for (size_t j = 0; j < (1 << lg_num_sketches); j++) {
-          frequent_items_sketch<unsigned> s(lg_max_sketch_size);
-          for (size_t k = 0; k < substream_length; k++) {
-            s.update(values[j * substream_length + k]);
+      });
+
+      scheduler.run(num_block_trials, [&](unsigned worker_index, size_t t) {
+        worker_state& worker = workers[worker_index];
+        const unsigned* trial_values = &values[t * stream_length];
+
+        std::unique_ptr<frequent_items_sketch<unsigned>> merged_sketch;
+        if (num_sketches > 1) {
+          merged_sketch.reset(new frequent_items_sketch<unsigned>(lg_max_sketch_size));
+          for (size_t part = 0; part < num_sketches; part++) {
+            merged_sketch->merge(*partial_sketches[t * num_sketches + part]);
           }
-          sketch.merge(s);
         }
-      }
-      num_items += sketch.get_num_active_items();
-      max_error += sketch.get_maximum_error();
+        const frequent_items_sketch<unsigned>& sketch = num_sketches > 1 ? *merged_sketch : *partial_sketches[t * num_sketches];
 
-      // brute-force frequent items
-      std::unordered_map<unsigned, unsigned> frequencies;
-      for (size_t j = 0; j < stream_length; j++) {
-        frequencies[values[j]]++;
-      }
-      std::unordered_map<unsigned, unsigned> frequent_items;
-      for (auto it: frequencies) {
-        if (it.second > threshold) frequent_items[it.first] = it.second;
-      }
+        // exact frequencies, counted in the array of this worker
+        worker.truth.clear();
+        worker.truth.add(trial_values, stream_length);
+        check_sketch(sketch, worker.truth, threshold, worker.counts);
 
-      // checks
+        for (size_t part = 0; part < num_sketches; part++) partial_sketches[t * num_sketches + part].reset();
+      });
+    }
 
-      // using a priori threshold (conservative)
+    // sums do not depend on how trials were distributed among workers
+    accuracy_counts counts;
+    for (auto& worker: workers) counts.add(worker.counts);
+    write_row(shard.out(), stream_length, num_trials, threshold, counts);
+  }
+}
 
-      // this must be a subset of the exact solution (only frequent items above threshold, not necessarily all of them)
-      auto conservative_no_false_positives = sketch.get_frequent_items(frequent_items_error_type::NO_FALSE_POSITIVES, threshold);
-      for (auto& it: conservative_no_false_positives) {
-        if (frequent_items.find(it.get_item()) == frequent_items.end()) {
-          num_error_1++;
-        }
-      }
+// Each trial feeds one stream into one sketch, and keeps the exact frequencies of the stream so far
+// in a running histogram, so every checkpoint is checked against the frequencies of its prefix.
+// The merge mode has no prefixes to share, so this mode always uses a single sketch.
+void frequent_items_sketch_accuracy_profile::run_incremental(sweep_shard& shard) {
+  const unsigned lg_min_stream_len = 5;
+  const unsigned lg_max_stream_len = 23;
+  const unsigned ppo = 16;
 
-      // the exact solution must be a subset of this (all frequent items above threshold must be present, and possibly some extra items)
-      auto conservative_no_false_negatives = sketch.get_frequent_items(frequent_items_error_type::NO_FALSE_NEGATIVES, threshold);
-      std::unordered_map<unsigned, unsigned> conservative_no_false_negatives_map;
-      for (auto& it: conservative_no_false_negatives) conservative_no_false_negatives_map[it.get_item()] = it.get_estimate();
-      for (auto& it: frequent_items) {
-        if (conservative_no_false_negatives_map.find(it.first) == conservative_no_false_negatives_map.end()) {
-          num_error_2++;
-        }
-      }
+  const unsigned lg_max_trials = 18;
+  const unsigned lg_min_trials = 10;
 
-      // using actual max error as threshold (the default)
-      // this is expected to find more items compared to using conservative threshold
+  const unsigned lg_max_sketch_size = 10;
 
-      auto no_false_positives = sketch.get_frequent_items(frequent_items_error_type::NO_FALSE_POSITIVES);
-      for (auto& it: no_false_positives) {
-        unsigned item = it.get_item();
-        if (frequent_items.find(item) == frequent_items.end()) {
-          extra_items++;
-        }
-      }
+  const unsigned zipf_lg_range = 13; // range: 8K values for 1K sketch
+  const double zipf_exponent = 0.7;
 
-      // all items of the exact solution must be in this set
-      auto no_false_negatives = sketch.get_frequent_items(frequent_items_error_type::NO_FALSE_NEGATIVES);
-      std::unordered_map<unsigned, unsigned> no_false_negatives_map;
-      for (auto& it: no_false_negatives) no_false_negatives_map[it.get_item()] = it.get_estimate();
-      for (auto& it: frequent_items) {
-        if (no_false_negatives_map.find(it.first) == no_false_negatives_map.end()) {
-          num_error_3++;
-        }
+  // values are drawn in chunks, so a trial does not hold its whole stream
+  const size_t chunk_size = 1 << 12;
+
+  // trials are seeded from this, so the output does not depend on the number of threads
+  const uint64_t seed(get_run_seed());
+
+  const prefix_sweep sweep(shard, lg_min_stream_len, lg_max_stream_len, ppo, [&](size_t stream_length) {
+    return get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
+  });
+  const size_t num_checkpoints = sweep.get_num_checkpoints();
+  if (num_checkpoints == 0) return;
+
+  std::vector<unsigned> thresholds(num_checkpoints);
+  for (size_t checkpoint = 0; checkpoint < num_checkpoints; checkpoint++) {
+    // trust sketch to compute epsilon
+    thresholds[checkpoint] = frequent_items_sketch<unsigned, unsigned>::get_epsilon(lg_max_sketch_size) * sweep.get_stream_length(checkpoint);
+  }
+
+  // each worker owns its generator, running histogram and counters of every checkpoint
+  struct worker_state {
+    zipf_distribution zipf;
+    exact_frequencies truth;
+    std::vector<unsigned> values;
+    std::vector<accuracy_counts> counts;
+    worker_state(zipf_distribution&& zipf, unsigned max_value, size_t chunk_size, size_t num_checkpoints):
+      zipf(std::move(zipf)), truth(max_value + 1), values(chunk_size), counts(num_checkpoints) {}
+  };
+  trial_scheduler scheduler;
+  std::vector<worker_state> workers;
+  for (unsigned i = 0; i < scheduler.get_num_threads(); i++) {
+    workers.emplace_back(zipf_distribution(1 << zipf_lg_range, zipf_exponent, seed, zipf_distribution::ALIAS_TABLE),
+        1 << zipf_lg_range, chunk_size, num_checkpoints);
+  }
+
+  scheduler.run(sweep.get_max_trials(), [&](unsigned worker_index, size_t trial) {
+    worker_state& worker = workers[worker_index];
+    worker.zipf.seed(derive_seed(seed, 0, trial));
+    worker.truth.clear();
+    frequent_items_sketch<unsigned> sketch(lg_max_sketch_size);
+    size_t i = 0;
+    for (size_t checkpoint = 0; checkpoint < sweep.get_num_checkpoints(trial); checkpoint++) {
+      const size_t stream_length = sweep.get_stream_length(checkpoint);
+      while (i < stream_length) {
+        const size_t n = std::min(chunk_size, stream_length - i);
+        worker.zipf.sample_n(worker.values.data(), n);
+        for (size_t j = 0; j < n; j++) sketch.update(worker.values[j]);
+        worker.truth.add(worker.values.data(), n);
+        i += n;
       }
+      check_sketch(sketch, worker.truth, thresholds[checkpoint], worker.counts[checkpoint]);
     }
-    delete [] values;
-
-    std::cout << stream_length
-        << "\t" << num_trials
-        << "\t" << (double) num_items / num_trials
-        << "\t" << threshold
-        << "\t" << (double) max_error / num_trials
-        << "\t" << (double) num_error_1 / num_trials
-        << "\t" << (double) num_error_2 / num_trials
-        << "\t" << (double) extra_items / num_trials
-        << "\t" << (double) num_error_3 / num_trials
-        << std::endl;
-
-    stream_length = pwr_2_law_next(ppo, stream_length);
+  });
+
+  for (size_t checkpoint = 0; checkpoint < num_checkpoints; checkpoint++) {
+    accuracy_counts counts;
+    for (auto& worker: workers) counts.add(worker.counts[checkpoint]);
+    write_row(shard.out(), sweep.get_stream_length(checkpoint), sweep.get_num_trials(checkpoint), thresholds[checkpoint], counts);
   }
 }
 
@@ -6,11 +6,19 @@
 #ifndef FREQUENT_ITEMS_SKETCH_ACCURACY_PROFILE_H_
 #define FREQUENT_ITEMS_SKETCH_ACCURACY_PROFILE_H_
 
+#include "profile.h"
+
 namespace datasketches {
 
-class frequent_items_sketch_accuracy_profile {
+class frequent_items_sketch_accuracy_profile: public profile {
 public:
-  void run();
+  // incremental: one stream per trial checked at every point, instead of a fresh stream per point
+  explicit frequent_items_sketch_accuracy_profile(bool incremental = false);
+  virtual void run(sweep_shard& shard);
+
+private:
+  bool incremental;
+  void run_incremental(sweep_shard& shard);
 };
 
 } /* namespace datasketches */
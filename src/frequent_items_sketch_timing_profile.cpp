@@ -4,13 +4,12 @@
  */
 
 #include "frequent_items_sketch_timing_profile.h"
-#include "characterization_utils.h"
+#include "timing_profile.h"
 #include "zipf_distribution.h"
+#include "trace_input.h"
+#include "counting_allocator.h"
 
-#include <iostream>
-#include <algorithm>
 #include <random>
-#include <chrono>
 #include <sstream>
 
 #include <frequent_items_sketch.hpp>
@@ -28,111 +27,72 @@ struct hash_long_long {
     return key;
   }
 };
-typedef frequent_items_sketch<long long, hash_long_long> frequent_longs_sketch;
-
-void frequent_items_sketch_timing_profile::run() {
-  const unsigned lg_min_stream_len = 0;
-  const unsigned lg_max_stream_len = 23;
-  const unsigned ppo = 16;
-
-  const unsigned lg_max_trials = 14;
-  const unsigned lg_min_trials = 8;
-
-  const unsigned lg_max_sketch_size = 10;
-
-  const unsigned zipf_lg_range = 13; // range: 8K values for 1K sketch
-  const double zipf_exponent = 0.7;
-  const double geom_p = 0.005;
-
-  std::default_random_engine generator(std::chrono::system_clock::now().time_since_epoch().count());
-  std::geometric_distribution<long long> geometric_distribution(geom_p);
-
-  zipf_distribution zipf(1 << zipf_lg_range, zipf_exponent);
-
-  std::cout << "StreamLen\tTrials\tBuild\tUpdate\tSerStream\tDeserStream\tSerBytes\tDeserBytes\tMaxErr\tNumItems\tSizeBytes" << std::endl;
-
-  size_t stream_length = 1 << lg_min_stream_len;
-  while (stream_length <= 1 << lg_max_stream_len) {
-    std::chrono::nanoseconds build_time_ns(0);
-    std::chrono::nanoseconds update_time_ns(0);
-    std::chrono::nanoseconds stream_serialize_time_ns(0);
-    std::chrono::nanoseconds stream_deserialize_time_ns(0);
-    std::chrono::nanoseconds bytes_serialize_time_ns(0);
-    std::chrono::nanoseconds bytes_deserialize_time_ns(0);
-    unsigned num_items = 0;
-    size_t size_bytes = 0;
-    size_t max_error = 0;
-
-    const size_t num_trials = get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
-
-    long long* values = new long long[stream_length];
-    for (size_t i = 0; i < num_trials; i++) {
-      const auto start_build(std::chrono::high_resolution_clock::now());
-      frequent_longs_sketch sketch(lg_max_sketch_size);
-      //frequent_longs_sketch sketch(lg_max_sketch_size, lg_max_sketch_size);
-      const auto finish_build(std::chrono::high_resolution_clock::now());
-      build_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_build - start_build);
-
-      // prepare values to exclude cost of random generator from the update loop
-      for (size_t j = 0; j < stream_length; j++) {
-        //values[j] = geometric_distribution(generator);
-        values[j] = zipf.sample();
+typedef frequent_items_sketch<long long, hash_long_long, std::equal_to<long long>, serde<long long>, counting_allocator<long long>> frequent_longs_sketch;
+
+// the input is generated once and reused across runs, or replayed from a trace,
+// each trial reads a different window of it
+struct frequent_items_timing_traits {
+  typedef frequent_longs_sketch sketch_type;
+  typedef long long item_type;
+  static const size_t lg_min_trials = 8;
+  static const size_t lg_max_trials = 14;
+
+  static const unsigned lg_max_sketch_size = 10;
+
+  static const unsigned zipf_lg_range = 13; // range: 8K values for 1K sketch
+  static constexpr double zipf_exponent = 0.7;
+  static constexpr double geom_p = 0.005;
+
+  static const uint64_t dataset_seed = 1;
+  static const size_t dataset_length = 1 << 24;
+
+  timing_input<long long> input;
+
+  frequent_items_timing_traits(): input(get_dataset_key(), dataset_length,
+      [](long long* items, size_t num_items) {
+        //std::default_random_engine generator(dataset_seed);
+        //std::geometric_distribution<long long> geometric_distribution(geom_p);
+        //for (size_t i = 0; i < num_items; i++) items[i] = geometric_distribution(generator);
+        zipf_distribution zipf(1 << zipf_lg_range, zipf_exponent, dataset_seed, zipf_distribution::ALIAS_TABLE);
+        zipf.sample_n(items, num_items);
       }
+  ) {}
 
-      const auto start_update(std::chrono::high_resolution_clock::now());
-      for (size_t j = 0; j < stream_length; ++j) {
-        sketch.update(values[j]);
-      }
-      const auto finish_update(std::chrono::high_resolution_clock::now());
-      update_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_update - start_update);
-
-      {
-        std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
-        auto start_stream_serialize(std::chrono::high_resolution_clock::now());
-        sketch.serialize(s);
-        const auto finish_stream_serialize(std::chrono::high_resolution_clock::now());
-        stream_serialize_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_stream_serialize - start_stream_serialize);
-
-        const auto start_stream_deserialize(std::chrono::high_resolution_clock::now());
-        auto deserialized_sketch = frequent_longs_sketch::deserialize(s);
-        const auto finish_stream_deserialize(std::chrono::high_resolution_clock::now());
-        stream_deserialize_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_stream_deserialize - start_stream_deserialize);
-
-        size_bytes += s.tellp();
-      }
+  static std::string get_dataset_key() {
+    std::ostringstream key;
+    key << "zipf_" << (1 << zipf_lg_range) << "_" << zipf_exponent << "_seed" << dataset_seed;
+    //key << "geometric_" << geom_p << "_seed" << dataset_seed;
+    return key.str();
+  }
 
-      {
-        auto start_bytes_serialize(std::chrono::high_resolution_clock::now());
-        auto pair = sketch.serialize();
-        const auto finish_bytes_serialize(std::chrono::high_resolution_clock::now());
-        bytes_serialize_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_bytes_serialize - start_bytes_serialize);
+  frequent_longs_sketch build() {
+    return frequent_longs_sketch(lg_max_sketch_size);
+    //return frequent_longs_sketch(lg_max_sketch_size, lg_max_sketch_size);
+  }
 
-        const auto start_bytes_deserialize(std::chrono::high_resolution_clock::now());
-        auto deserialized_sketch = frequent_longs_sketch::deserialize(pair.first.get(), pair.second);
-        const auto finish_bytes_deserialize(std::chrono::high_resolution_clock::now());
-        bytes_deserialize_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_bytes_deserialize - start_bytes_deserialize);
-      }
+  const long long* get_items(size_t stream_length, size_t trial) {
+    return input.get_items(stream_length, trial);
+  }
 
-      num_items += sketch.get_num_active_items();
-      max_error += sketch.get_maximum_error();
-    }
-    delete [] values;
-
-    std::cout << stream_length << "\t"
-        << num_trials << "\t"
-        << (double) build_time_ns.count() / num_trials << "\t"
-        << (double) update_time_ns.count() / num_trials / stream_length << "\t"
-        << (double) stream_serialize_time_ns.count() / num_trials << "\t"
-        << (double) stream_deserialize_time_ns.count() / num_trials << "\t"
-        << (double) bytes_serialize_time_ns.count() / num_trials << "\t"
-        << (double) bytes_deserialize_time_ns.count() / num_trials << "\t"
-        << (double) max_error / num_trials << "\t"
-        << (double) num_items / num_trials << "\t"
-        << (double) size_bytes / num_trials << "\t"
-        << std::endl;
-
-    stream_length = pwr_2_law_next(ppo, stream_length);
+  auto make_operations() {
+    const auto serialize_stream = [](const frequent_longs_sketch& sketch, std::ostream& os) { sketch.serialize(os); };
+    const auto deserialize_bytes = [](const void* bytes, size_t size) { return frequent_longs_sketch::deserialize(bytes, size); };
+    return std::make_tuple(
+      make_stream_serde_timing("SerStream", "DeserStream", serialize_stream,
+          [](std::istream& is) { return frequent_longs_sketch::deserialize(is); }),
+      make_bytes_serde_timing("SerBytes", "DeserBytes",
+          [](const frequent_longs_sketch& sketch) { return sketch.serialize(); }, deserialize_bytes),
+      make_statistic("MaxErr", [](const frequent_longs_sketch& sketch) { return sketch.get_maximum_error(); }),
+      make_statistic("NumItems", [](const frequent_longs_sketch& sketch) { return sketch.get_num_active_items(); }),
+      make_statistic("SizeBytes", get_serialized_size_bytes<frequent_longs_sketch>),
+      make_buffer_serde_timing("SerBuf", "DeserBuf", serialize_stream, deserialize_bytes),
+      make_mapped_serde_timing("SerMap", "DeserMap", serialize_stream, deserialize_bytes)
+    );
   }
+};
+
+void frequent_items_sketch_timing_profile::run(sweep_shard& shard) {
+  timing_profile<frequent_items_timing_traits>().run(shard);
 }
 
 } /* namespace datasketches */
@@ -6,11 +6,13 @@
 #ifndef FREQUENT_ITEMS_SKETCH_TIMING_PROFILE_H_
 #define FREQUENT_ITEMS_SKETCH_TIMING_PROFILE_H_
 
+#include "profile.h"
+
 namespace datasketches {
 
-class frequent_items_sketch_timing_profile {
+class frequent_items_sketch_timing_profile: public profile {
 public:
-  void run();
+  virtual void run(sweep_shard& shard);
 };
 
 } /* namespace datasketches */
@@ -0,0 +1,278 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "frequent_strings_timing_profile.h"
+#include "timing_profile.h"
+#include "zipf_distribution.h"
+#include "string_arena.h"
+#include "trace_input.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include <frequent_items_sketch.hpp>
+
+namespace datasketches {
+
+typedef std::basic_string<char, std::char_traits<char>, arena_allocator<char>> arena_string;
+
+// The same hash for both variants, 8 bytes at a time with the MurmurHash3 finalizer as the mixing step
+struct string_hash {
+  static uint64_t mix(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+  }
+  template<typename String>
+  size_t operator()(const String& key) const {
+    const char* data = key.data();
+    const size_t size = key.size();
+    uint64_t hash = 0x9e3779b97f4a7c13ULL ^ size;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data + i, sizeof(word));
+      hash = (hash ^ mix(word)) * 0x9e3779b97f4a7c13ULL;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    return mix(hash ^ tail);
+  }
+};
+
+// length-prefixed strings
+template<typename String>
+struct string_serde {
+  void serialize(std::ostream& os, const String* items, unsigned num) {
+    for (unsigned i = 0; i < num; i++) {
+      const uint32_t length = items[i].size();
+      os.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      os.write(items[i].data(), length);
+    }
+  }
+  void deserialize(std::istream& is, String* items, unsigned num) {
+    for (unsigned i = 0; i < num; i++) {
+      uint32_t length;
+      is.read(reinterpret_cast<char*>(&length), sizeof(length));
+      new (&items[i]) String(length, '\0');
+      is.read(&items[i][0], length);
+    }
+  }
+  size_t serialize(char* ptr, const String* items, unsigned num) {
+    const char* start = ptr;
+    for (unsigned i = 0; i < num; i++) {
+      const uint32_t length = items[i].size();
+      memcpy(ptr, &length, sizeof(length));
+      memcpy(ptr + sizeof(length), items[i].data(), length);
+      ptr += sizeof(length) + length;
+    }
+    return ptr - start;
+  }
+  size_t deserialize(const char* ptr, String* items, unsigned num) {
+    const char* start = ptr;
+    for (unsigned i = 0; i < num; i++) {
+      uint32_t length;
+      memcpy(&length, ptr, sizeof(length));
+      new (&items[i]) String(ptr + sizeof(length), length);
+      ptr += sizeof(length) + length;
+    }
+    return ptr - start;
+  }
+  size_t size_of_item(const String& item) { return sizeof(uint32_t) + item.size(); }
+};
+
+/*
+ * Keys with a mix of URL and user agent lengths (log-normal, clamped): a fixed prefix, the key id in hex,
+ * so that all keys are distinct, and random characters up to the length.
+ */
+template<typename String>
+static std::vector<String> make_keys(size_t num_keys, size_t first_id, uint64_t seed) {
+  const double url_share = 0.7;
+  const double url_median_length = 60;
+  const double url_sigma = 0.6;
+  const double user_agent_median_length = 120;
+  const double user_agent_sigma = 0.25;
+  const size_t max_length = 1024;
+
+  const char url_prefix[] = "https://www.example.com/";
+  const char user_agent_prefix[] = "Mozilla/5.0 (X11; Linux x86_64) ";
+  const char filler[] = "abcdefghijklmnopqrstuvwxyz0123456789/-_.?=&";
+
+  std::default_random_engine generator(seed);
+  std::bernoulli_distribution is_url(url_share);
+  std::lognormal_distribution<double> url_length(std::log(url_median_length), url_sigma);
+  std::lognormal_distribution<double> user_agent_length(std::log(user_agent_median_length), user_agent_sigma);
+  std::uniform_int_distribution<size_t> filler_char(0, sizeof(filler) - 2);
+
+  std::vector<String> keys;
+  keys.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    const bool url = is_url(generator);
+    String key(url ? url_prefix : user_agent_prefix);
+    char id[17];
+    snprintf(id, sizeof(id), "%zx", first_id + i);
+    key += id;
+    const size_t length = std::min(max_length, (size_t) (url ? url_length(generator) : user_agent_length(generator)));
+    while (key.size() < length) key += filler[filler_char(generator)];
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+/*
+ * The stream is a window of Zipf-distributed references to the keys, copied into an array of keys,
+ * so that every update copies a key the way a real stream of strings would.
+ * The arena variant makes a new arena current in build(), so the sketch of each trial and everything
+ * derived from it in the operations allocate from one arena that is reset for the next trial.
+ * The input keys live in their own arena.
+ */
+template<typename String, typename Allocator>
+struct frequent_strings_timing_traits {
+  typedef frequent_items_sketch<String, string_hash, std::equal_to<String>, string_serde<String>, Allocator> sketch_type;
+  typedef String item_type;
+  static const size_t lg_min_trials = 6;
+  static const size_t lg_max_trials = 12;
+  // an array of 2^20 strings is already about 100MB
+  static const size_t lg_max_stream_len = 20;
+
+  static const unsigned lg_max_sketch_size = 10;
+
+  static const unsigned zipf_lg_range = 16;
+  static constexpr double zipf_exponent = 0.7;
+
+  static const uint64_t dataset_seed = 1;
+  static const size_t dataset_length = 1 << lg_max_stream_len;
+  // keys never seen in the stream, each of them is inserted and eventually purged
+  static const size_t num_new_keys = 1 << 12;
+
+  string_arena input_arena;
+  string_arena sketch_arena;
+  bool use_arena;
+  std::vector<String> items;
+  std::vector<String> new_keys;
+  std::vector<String> buffer;
+
+  frequent_strings_timing_traits(): use_arena(std::is_same<Allocator, arena_allocator<String>>::value) {
+    if (use_arena) string_arena::set_current(&input_arena);
+    const std::vector<String> keys = make_keys<String>(1 << zipf_lg_range, 0, dataset_seed);
+    zipf_distribution zipf(1 << zipf_lg_range, zipf_exponent, dataset_seed, zipf_distribution::ALIAS_TABLE);
+    std::vector<unsigned> references(dataset_length);
+    zipf.sample_n(references.data(), dataset_length);
+    items.reserve(dataset_length);
+    for (unsigned reference: references) items.push_back(keys[reference - 1]);
+    new_keys = make_keys<String>(num_new_keys, 1 << zipf_lg_range, dataset_seed + 1);
+  }
+
+  ~frequent_strings_timing_traits() {
+    // the input keys are freed to their own arena
+    if (use_arena) string_arena::set_current(&input_arena);
+  }
+
+  sketch_type build() {
+    if (use_arena) {
+      sketch_arena.clear();
+      string_arena::set_current(&sketch_arena);
+    }
+    return sketch_type(lg_max_sketch_size);
+  }
+
+  const String* get_items(size_t stream_length, size_t trial) {
+    return get_window(items.data(), items.size(), stream_length, trial, buffer);
+  }
+
+  auto make_operations() {
+    const auto serialize_stream = [](const sketch_type& sketch, std::ostream& os) { sketch.serialize(os); };
+    return std::make_tuple(
+      purge_timing(new_keys),
+      merge_timing(),
+      make_stream_serde_timing("SerStream", "DeserStream", serialize_stream,
+          [](std::istream& is) { return sketch_type::deserialize(is); }),
+      make_bytes_serde_timing("SerBytes", "DeserBytes",
+          [](const sketch_type& sketch) { return sketch.serialize(); },
+          [](const void* bytes, size_t size) { return sketch_type::deserialize(bytes, size); }),
+      make_statistic("NumItems", [](const sketch_type& sketch) { return sketch.get_num_active_items(); }),
+      make_statistic("SizeBytes", get_serialized_size_bytes<sketch_type>)
+    );
+  }
+
+  /*
+   * Update of a copy of the trial sketch with keys that it has never seen, which makes it purge repeatedly.
+   * Purge is the time of these updates per purge that they caused, Purges is the number of purges.
+   * The purges are counted on another copy beforehand, outside of the timed region.
+   */
+  class purge_timing {
+  public:
+    explicit purge_timing(const std::vector<String>& keys): column("Purge"), keys(keys), num_purges(0) {}
+    void header(std::ostream& os) const { os << "\t" << column.get_name() << "\tPurges"; }
+    void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&column); }
+    void clear() { column.clear(); num_purges = 0; }
+    void run(const sketch_type& sketch, const String*, size_t) {
+      size_t purges = 0;
+      {
+        sketch_type copy(sketch);
+        uint32_t num_items = copy.get_num_active_items();
+        for (const auto& key: keys) {
+          copy.update(key);
+          if (copy.get_num_active_items() < num_items) purges++;
+          num_items = copy.get_num_active_items();
+        }
+      }
+      num_purges += purges;
+      sketch_type copy(sketch);
+      const auto start(column.start());
+      for (const auto& key: keys) copy.update(key);
+      column.stop(start, std::max<size_t>(purges, 1));
+      do_not_optimize(copy.get_num_active_items());
+    }
+    void print(std::ostream& os, size_t num_trials) const {
+      os << "\t" << column.get_mean() << "\t" << (double) num_purges / num_trials;
+    }
+  private:
+    timing_column column;
+    const std::vector<String>& keys;
+    size_t num_purges;
+  };
+
+  // merge of the trial sketch into a sketch of the first half of the same stream, which shares some keys
+  class merge_timing {
+  public:
+    merge_timing(): column("Merge") {}
+    void header(std::ostream& os) const { os << "\t" << column.get_name(); }
+    void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&column); }
+    void clear() { column.clear(); }
+    void run(const sketch_type& sketch, const String* items, size_t stream_length) {
+      sketch_type target(lg_max_sketch_size);
+      for (size_t i = 0; i < stream_length / 2; i++) target.update(items[i]);
+      const auto start(column.start());
+      target.merge(sketch);
+      column.stop(start);
+      do_not_optimize(target.get_num_active_items());
+    }
+    void print(std::ostream& os, size_t) const { os << "\t" << column.get_mean(); }
+  private:
+    timing_column column;
+  };
+};
+
+frequent_strings_timing_profile::frequent_strings_timing_profile(bool arena): arena(arena) {}
+
+void frequent_strings_timing_profile::run(sweep_shard& shard) {
+  if (arena) {
+    timing_profile<frequent_strings_timing_traits<arena_string, arena_allocator<arena_string>>>().run(shard);
+  } else {
+    timing_profile<frequent_strings_timing_traits<std::string, std::allocator<std::string>>>().run(shard);
+  }
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef FREQUENT_STRINGS_TIMING_PROFILE_H_
+#define FREQUENT_STRINGS_TIMING_PROFILE_H_
+
+#include "profile.h"
+
+namespace datasketches {
+
+/*
+ * Timing of a frequent items sketch of string keys with the lengths of URLs and user agents.
+ * The keys are std::string, or, with arena set, strings whose memory comes from a per-sketch string_arena.
+ * Both variants print the same columns, so the two results can be compared with the compare command.
+ */
+class frequent_strings_timing_profile: public profile {
+public:
+  explicit frequent_strings_timing_profile(bool arena);
+  virtual void run(sweep_shard& shard);
+
+private:
+  bool arena;
+};
+
+} /* namespace datasketches */
+
+#endif /* FREQUENT_STRINGS_TIMING_PROFILE_H_ */
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "hll_sketch_timing_profile.h"
+#include "timing_profile.h"
+#include "distinct_count_timing.h"
+#include "counting_allocator.h"
+
+namespace datasketches {
+
+typedef hll_sketch_alloc<counting_allocator<char>> counted_hll_sketch;
+
+template<target_hll_type type>
+struct hll_timing_traits: public distinct_count_timing_traits {
+  typedef counted_hll_sketch sketch_type;
+
+  counted_hll_sketch build() { return counted_hll_sketch(10, type); }
+
+  auto make_operations() {
+    return std::make_tuple(
+      make_stream_serde_timing("Ser", "Deser",
+          [](const counted_hll_sketch& sketch, std::ostream& os) { sketch.serialize_compact(os); },
+          [](std::istream& is) { return counted_hll_sketch::deserialize(is); }),
+      make_statistic("Size", [](const counted_hll_sketch& sketch) { return sketch.get_compact_serialization_bytes(); })
+    );
+  }
+};
+
+hll_sketch_timing_profile::hll_sketch_timing_profile(target_hll_type type): type(type) {}
+
+void hll_sketch_timing_profile::run(sweep_shard& shard) {
+  switch (type) {
+    case HLL_4: timing_profile<hll_timing_traits<HLL_4>>().run(shard); break;
+    case HLL_6: timing_profile<hll_timing_traits<HLL_6>>().run(shard); break;
+    case HLL_8: timing_profile<hll_timing_traits<HLL_8>>().run(shard); break;
+  }
+}
+
+} /* namespace datasketches */
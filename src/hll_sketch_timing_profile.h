@@ -0,0 +1,25 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef HLL_SKETCH_TIMING_PROFILE_H_
+#define HLL_SKETCH_TIMING_PROFILE_H_
+
+#include "profile.h"
+
+#include <hll.hpp>
+
+namespace datasketches {
+
+class hll_sketch_timing_profile: public profile {
+public:
+  explicit hll_sketch_timing_profile(target_hll_type type);
+  virtual void run(sweep_shard& shard);
+private:
+  target_hll_type type;
+};
+
+} /* namespace datasketches */
+
+#endif /* HLL_SKETCH_TIMING_PROFILE_H_ */
@@ -6,14 +6,69 @@
 #ifndef KLL_ACCURACY_PROFILE_H_
 #define KLL_ACCURACY_PROFILE_H_
 
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+#include "profile.h"
+#include "characterization_utils.h"
+#include "trial_scheduler.h"
+
 namespace datasketches {
 
-class kll_accuracy_profile {
+class kll_accuracy_profile: public profile {
 public:
-  virtual void run();
-  virtual double run_trial(float* values, unsigned stream_length) = 0;
+  virtual void run(sweep_shard& shard);
+  // values contain 0..stream_length-1 in order, the trial is expected to shuffle them using the given seed
+  virtual double run_trial(float* values, unsigned stream_length, uint64_t seed) = 0;
 };
 
+/*
+ * The sweep of kll_accuracy_profile for items of type T: the 99th percentile of the rank errors
+ * of run_trial(T* values, unsigned stream_length, uint64_t seed) over 100 trials per point,
+ * where values contain 0..stream_length-1 in order as in kll_accuracy_profile::run_trial().
+ * Each worker owns a buffer for the values that grows with the stream length, and the number
+ * of workers is limited so that the buffers at the end of the sweep take at most 2GB together.
+ */
+template<typename T, typename Trial>
+void run_kll_accuracy_sweep(sweep_shard& shard, Trial&& run_trial) {
+  const unsigned lg_min(0);
+  const unsigned lg_max(23);
+  const unsigned ppo(16);
+  const unsigned num_trials(100);
+  const unsigned error_pct(99);
+  const size_t max_buffer_bytes(1ULL << 31);
+
+  // trials are seeded from this, so the output does not depend on the number of threads
+  const uint64_t seed(get_run_seed());
+
+  double rank_errors[num_trials];
+
+  const unsigned max_threads = std::max<size_t>(1, max_buffer_bytes / (sizeof(T) << lg_max));
+  trial_scheduler scheduler(std::min(trial_scheduler().get_num_threads(), max_threads));
+  std::vector<std::vector<T>> values(scheduler.get_num_threads());
+
+  const unsigned num_steps = count_points(lg_min, lg_max, ppo);
+  unsigned stream_length(1 << lg_min);
+  for (unsigned i = 0; i < num_steps; i++, stream_length = pwr_2_law_next(ppo, stream_length)) {
+    if (!shard.should_run(stream_length)) continue;
+
+    scheduler.run(num_trials, [&](unsigned worker, size_t t) {
+      std::vector<T>& trial_values = values[worker];
+      if (trial_values.size() < stream_length) trial_values.resize(stream_length);
+      for (unsigned i = 0; i < stream_length; i++) trial_values[i] = i;
+      rank_errors[t] = run_trial(trial_values.data(), stream_length, derive_seed(seed, stream_length, t));
+    });
+
+    shard.add_row_samples({{"RankError", std::vector<double>(&rank_errors[0], &rank_errors[num_trials])}});
+    std::sort(&rank_errors[0], &rank_errors[num_trials]);
+    const unsigned error_pct_index = num_trials * error_pct / 100;
+    const double rank_error = rank_errors[error_pct_index];
+
+    shard.out() << stream_length << "\t" << rank_error * 100 << std::endl;
+  }
+}
+
 } /* namespace datasketches */
 
 #endif /* KLL_ACCURACY_PROFILE_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "kll_matrix_accuracy_profile.h"
+#include "kll_sketch_accuracy_profile.h"
+#include "kll_type_matrix.h"
+
+namespace datasketches {
+
+void kll_matrix_accuracy_profile::run(sweep_shard& shard) {
+  const std::vector<uint16_t> k_values = get_kll_matrix_k_values();
+  for_each_type(kll_matrix_types(), [&](auto entry) {
+    typedef decltype(entry) entry_type;
+    typedef typename entry_type::item_type T;
+    typedef typename entry_type::comparator C;
+    for (uint16_t k: k_values) {
+      shard.begin_section(get_kll_matrix_section<entry_type>(k));
+      shard.header() << "Stream\tRankError" << std::endl;
+      run_kll_accuracy_sweep<T>(shard, [k](T* values, unsigned stream_length, uint64_t seed) {
+        return run_kll_sketch_trial<T, C>(values, stream_length, seed, k);
+      });
+    }
+  });
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,24 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef KLL_MATRIX_ACCURACY_PROFILE_H_
+#define KLL_MATRIX_ACCURACY_PROFILE_H_
+
+#include "profile.h"
+
+namespace datasketches {
+
+/*
+ * The rank error of kll-accuracy for every item type of kll_matrix_types and every k
+ * from get_kll_matrix_k_values(), each in its own section.
+ */
+class kll_matrix_accuracy_profile: public profile {
+public:
+  virtual void run(sweep_shard& shard);
+};
+
+} /* namespace datasketches */
+
+#endif /* KLL_MATRIX_ACCURACY_PROFILE_H_ */
@@ -4,17 +4,16 @@
  */
 
 #include "kll_merge_accuracy_profile.h"
+#include "kll_rank_error.h"
 
 #include <algorithm>
 #include <random>
-#include <chrono>
 
 #include <kll_sketch.hpp>
 
 namespace datasketches {
 
-double kll_merge_accuracy_profile::run_trial(float* values, unsigned stream_length) {
-  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+double kll_merge_accuracy_profile::run_trial(float* values, unsigned stream_length, uint64_t seed) {
   std::shuffle(values, values + stream_length, std::default_random_engine(seed));
 
   const unsigned num_sketches(8);
@@ -36,14 +35,7 @@ double kll_merge_accuracy_profile::run_trial(float* values, unsigned stream_leng
   kll_sketch<float> sketch;
   sketch.merge(sketch_tmp);
 
-  double max_rank_error = 0;
-  for (size_t i = 0; i < stream_length; i++) {
-    double true_rank = (double) i / stream_length;
-    double est_rank = sketch.get_rank(i);
-    max_rank_error = std::max(max_rank_error, abs(true_rank - est_rank));
-  }
-
-  return max_rank_error;
+  return kll_max_rank_error(sketch, stream_length);
 }
 
 } /* namespace datasketches */
@@ -12,7 +12,7 @@ namespace datasketches {
 
 class kll_merge_accuracy_profile: public kll_accuracy_profile {
 public:
-  virtual double run_trial(float* values, unsigned stream_length);
+  virtual double run_trial(float* values, unsigned stream_length, uint64_t seed);
 };
 
 } /* namespace datasketches */
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "kll_merge_timing_profile.h"
+#include "characterization_utils.h"
+#include "dataset_cache.h"
+#include "timing_core.h"
+#include "trial_scheduler.h"
+#include "cpu_isolation.h"
+#include "counting_allocator.h"
+
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include <kll_sketch.hpp>
+
+namespace datasketches {
+
+typedef kll_sketch<float, std::less<float>, serde<float>, counting_allocator<float>> kll_float_sketch;
+
+// time from a common start to the last thread finishing its part of the stream,
+// the threads are started and wait for the common start, so their creation is not timed
+static double parallel_ingest(std::vector<kll_float_sketch>& sketches, const float* values, size_t stream_length) {
+  const size_t num_threads = sketches.size();
+  std::atomic<bool> go(false);
+  std::atomic<size_t> num_ready(0);
+  std::vector<timer::time_point> finish(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      pin_thread(t);
+      const size_t begin = stream_length * t / num_threads;
+      const size_t end = stream_length * (t + 1) / num_threads;
+      num_ready++;
+      while (!go.load(std::memory_order_acquire)) {}
+      for (size_t i = begin; i < end; i++) sketches[t].update(values[i]);
+      finish[t] = timer::now();
+    });
+  }
+  // all threads are running and pinned before the common start
+  while (num_ready.load() < num_threads) std::this_thread::yield();
+  const auto start = timer::now();
+  go.store(true, std::memory_order_release);
+  for (auto& thread: threads) thread.join();
+  timer::time_point last = start;
+  for (auto& time: finish) if (time > last) last = time;
+  return std::chrono::duration<double, std::nano>(last - start).count();
+}
+
+// threads wait in wait() until all of them arrived, then it can be used for the next round
+class spin_barrier {
+public:
+  explicit spin_barrier(unsigned num_threads): num_threads(num_threads), num_waiting(0), generation(0) {}
+  void wait() {
+    const unsigned current = generation.load();
+    if (++num_waiting == num_threads) {
+      num_waiting = 0;
+      generation.store(current + 1);
+    } else {
+      while (generation.load() == current) std::this_thread::yield();
+    }
+  }
+private:
+  const unsigned num_threads;
+  std::atomic<unsigned> num_waiting;
+  std::atomic<unsigned> generation;
+};
+
+// pairs are merged in parallel in each round, log2(number of sketches) rounds separated by a barrier,
+// the threads are started and wait for the common start, so their creation is not timed
+static double parallel_tree_merge(std::vector<kll_float_sketch>& sketches) {
+  const size_t num_threads = (sketches.size() + 1) / 2;
+  std::atomic<bool> go(false);
+  std::atomic<size_t> num_ready(0);
+  spin_barrier barrier(num_threads);
+  timer::time_point finish;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      pin_thread(t);
+      num_ready++;
+      while (!go.load(std::memory_order_acquire)) {}
+      for (size_t step = 1; step < sketches.size(); step *= 2) {
+        // thread t merges pair t of the round
+        const size_t target = t * 2 * step;
+        if (target + step < sketches.size()) sketches[target].merge(sketches[target + step]);
+        barrier.wait();
+      }
+      if (t == 0) finish = timer::now();
+    });
+  }
+  // all threads are running and pinned before the common start
+  while (num_ready.load() < num_threads) std::this_thread::yield();
+  const auto start = timer::now();
+  go.store(true, std::memory_order_release);
+  for (auto& thread: threads) thread.join();
+  return std::chrono::duration<double, std::nano>(finish - start).count();
+}
+
+void kll_merge_timing_profile::run(sweep_shard& shard) {
+  const size_t lg_min_stream_len(10);
+  const size_t lg_max_stream_len(23);
+  const size_t ppo(4);
+
+  const size_t lg_max_trials(10);
+  const size_t lg_min_trials(4);
+
+  const size_t num_warmup_trials(2);
+
+  const unsigned max_threads(trial_scheduler().get_num_threads());
+
+  // the input is generated once and reused across runs, each trial reads a different window of it
+  const uint64_t dataset_seed(1);
+  const size_t dataset_length(1 << (lg_max_stream_len + 1));
+  dataset_cache cache;
+  const auto dataset = cache.get<float>("uniform_float_0_1_seed" + std::to_string(dataset_seed), dataset_length,
+      [dataset_seed](float* items, size_t num_items) {
+        std::default_random_engine generator(dataset_seed);
+        std::uniform_real_distribution<float> distribution(0.0, 1.0);
+        for (size_t i = 0; i < num_items; i++) items[i] = distribution(generator);
+      }
+  );
+
+  shard.header() << "Stream\tThreads\tTrials\tUpdatesPerSec\tIngest\tLinearMerge\tTreeMerge\tRetained";
+
+  timing_column ingest("Ingest");
+  timing_column linear_merge("LinearMerge");
+  timing_column tree_merge("TreeMerge");
+  const std::vector<timing_column*> columns = {&ingest, &linear_merge, &tree_merge};
+  // allocations and counters are per thread, only the linear merge runs on this thread alone
+  const std::vector<timing_column*> stats_columns = {&linear_merge};
+  print_timing_summary_header(shard.header(), columns, stats_columns);
+  shard.header() << std::endl;
+
+  std::vector<unsigned> thread_counts;
+  for (unsigned n = 1; n < max_threads; n *= 2) thread_counts.push_back(n);
+  thread_counts.push_back(max_threads);
+
+  for (size_t stream_length = 1 << lg_min_stream_len; stream_length <= (1 << lg_max_stream_len); stream_length = pwr_2_law_next(ppo, stream_length)) {
+    if (!shard.should_run(stream_length)) continue;
+
+    // all rows of a point are written together, so an interrupted point is computed again on restart
+    std::ostringstream rows;
+    const size_t num_trials = get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
+
+    for (unsigned num_threads: thread_counts) {
+      size_t num_retained(0);
+
+      for (size_t i = 0; i < num_warmup_trials + num_trials; i++) {
+        if (i == num_warmup_trials) {
+          // discard measurements of the warmup trials
+          for (auto column: columns) column->clear();
+          num_retained = 0;
+        }
+        const float* values = dataset.data() + (i * stream_length) % (dataset_length - stream_length + 1);
+
+        std::vector<kll_float_sketch> sketches(num_threads);
+        ingest.add_sample(parallel_ingest(sketches, values, stream_length) / stream_length);
+
+        // linear: every sketch is merged into the result one after another
+        {
+          const auto start_merge(linear_merge.start());
+          kll_float_sketch result;
+          for (auto& sketch: sketches) result.merge(sketch);
+          linear_merge.stop(start_merge);
+          num_retained += result.get_num_retained();
+        }
+
+        // tree: pairs are merged in parallel, log2(num_threads) rounds
+        tree_merge.add_sample(num_threads > 1 ? parallel_tree_merge(sketches) : 0);
+      }
+
+      shard.add_row_samples(get_raw_samples(columns));
+      rows << stream_length << "\t"
+          << num_threads << "\t"
+          << num_trials << "\t"
+          << 1e9 / ingest.get_mean() << "\t"
+          << ingest.get_mean() << "\t"
+          << linear_merge.get_mean() << "\t"
+          << tree_merge.get_mean() << "\t"
+          << num_retained / num_trials;
+      print_timing_summary(rows, columns, stats_columns);
+      rows << std::endl;
+    }
+    shard.out() << rows.str() << std::flush;
+  }
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef KLL_MERGE_TIMING_PROFILE_H_
+#define KLL_MERGE_TIMING_PROFILE_H_
+
+#include "profile.h"
+
+namespace datasketches {
+
+/*
+ * Parallel ingest into one sketch per thread followed by merging the sketches,
+ * comparing a linear merge into one sketch with a pairwise tree reduction running on the same threads.
+ * Produces a row for every number of threads (and sketches) from 1 to the number of cores at each stream length.
+ */
+class kll_merge_timing_profile: public profile {
+public:
+  virtual void run(sweep_shard& shard);
+};
+
+} /* namespace datasketches */
+
+#endif /* KLL_MERGE_TIMING_PROFILE_H_ */
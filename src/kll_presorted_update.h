@@ -0,0 +1,51 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef KLL_PRESORTED_UPDATE_H_
+#define KLL_PRESORTED_UPDATE_H_
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+#include <kll_sketch.hpp>
+
+namespace datasketches {
+
+/*
+ * Feeds blocks of values into a kll_sketch in sorted chunks.
+ * This is not a bulk path: the sketch accepts one item at a time, so every item still goes through update().
+ * The block is copied in chunks of k items (the capacity of level 0 of a fresh sketch), and each chunk
+ * is sorted in descending order before it is fed. Level 0 is filled from its end, so such a chunk lies
+ * in ascending order when level 0 is sorted for compaction, which makes that sort cheaper.
+ * Whether that pays for the copy and the O(k log k) sort of every chunk is what the timing measures.
+ * A chunk that crosses a compaction is split between two compactions in sorted order instead of
+ * in stream order, so the result is not the same as with per-item updates of the block.
+ * The scratch buffer for the chunks is kept between calls.
+ */
+template<typename T, typename C = std::less<T>>
+class kll_presorted_updater {
+public:
+  explicit kll_presorted_updater(size_t chunk_size = 200): chunk_size(chunk_size), chunk(chunk_size) {}
+
+  template<typename S, typename A>
+  void update(kll_sketch<T, C, S, A>& sketch, const T* values, size_t num_values) {
+    const C comparator;
+    for (size_t offset = 0; offset < num_values; offset += chunk_size) {
+      const size_t size = std::min(chunk_size, num_values - offset);
+      std::copy(values + offset, values + offset + size, chunk.begin());
+      std::sort(chunk.begin(), chunk.begin() + size, [&comparator](const T& a, const T& b) { return comparator(b, a); });
+      for (size_t i = 0; i < size; i++) sketch.update(chunk[i]);
+    }
+  }
+
+private:
+  size_t chunk_size;
+  std::vector<T> chunk;
+};
+
+} /* namespace datasketches */
+
+#endif /* KLL_PRESORTED_UPDATE_H_ */
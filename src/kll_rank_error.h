@@ -0,0 +1,86 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef KLL_RANK_ERROR_H_
+#define KLL_RANK_ERROR_H_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+#include <kll_sketch.hpp>
+
+#include "fenwick_tree.h"
+
+namespace datasketches {
+
+/*
+ * Computes the maximum normalized rank error of a sketch built from a permutation of 0..stream_length-1,
+ * so that the true rank of value i is i / stream_length.
+ * This gives exactly the same result as calling sketch.get_rank(i) for every i, but instead of scanning
+ * the retained items for each i, the retained items are sorted once and walked together with i.
+ * The estimated rank is the total weight of retained items less than i divided by n, as in get_rank().
+ */
+template<typename T, typename C, typename S, typename A>
+double kll_max_rank_error(const kll_sketch<T, C, S, A>& sketch, size_t stream_length) {
+  std::vector<std::pair<T, uint64_t>> items;
+  items.reserve(sketch.get_num_retained());
+  for (auto it: sketch) items.push_back(std::pair<T, uint64_t>(it.first, it.second));
+  std::sort(items.begin(), items.end(),
+      [](const std::pair<T, uint64_t>& a, const std::pair<T, uint64_t>& b) { return C()(a.first, b.first); });
+
+  const uint64_t n = sketch.get_n();
+  uint64_t weight = 0; // total weight of retained items less than the current value
+  size_t next = 0;
+  double max_rank_error = 0;
+  for (size_t i = 0; i < stream_length; i++) {
+    const T value(i);
+    while (next < items.size() && C()(items[next].first, value)) weight += items[next++].second;
+    const double true_rank = (double) i / stream_length;
+    const double est_rank = (double) weight / n;
+    max_rank_error = std::max(max_rank_error, std::abs(true_rank - est_rank));
+  }
+  return max_rank_error;
+}
+
+/*
+ * Maximum normalized rank error over the values of a prefix of a stream of distinct integers,
+ * with the prefix counted in the given tree, so that the true rank of a value is the number of smaller values.
+ * Between two consecutive retained items the estimated rank is constant and the true rank only grows,
+ * so the maximum is reached either at the smallest stream value above the previous retained item
+ * or at the next retained item itself. This checks the same values as scanning the whole prefix,
+ * but in O(retained * log(domain)), so that a prefix can be evaluated at every checkpoint of a long stream.
+ */
+template<typename T, typename C, typename S, typename A>
+double kll_max_rank_error(const kll_sketch<T, C, S, A>& sketch, const fenwick_tree& truth) {
+  std::vector<std::pair<T, uint64_t>> items;
+  items.reserve(sketch.get_num_retained());
+  for (auto it: sketch) items.push_back(std::pair<T, uint64_t>(it.first, it.second));
+  std::sort(items.begin(), items.end(),
+      [](const std::pair<T, uint64_t>& a, const std::pair<T, uint64_t>& b) { return C()(a.first, b.first); });
+
+  const uint64_t n = sketch.get_n();
+  uint64_t weight = 0; // total weight of retained items up to the previous one
+  uint64_t num_less_or_equal = 0; // true count of stream values up to the previous retained item
+  double max_rank_error = 0;
+  for (const auto& item: items) {
+    const uint64_t num_less = truth.count_less((size_t) item.first);
+    if (num_less > num_less_or_equal) { // there are stream values in between
+      max_rank_error = std::max(max_rank_error, std::abs((double) num_less_or_equal - (double) weight) / n);
+    }
+    max_rank_error = std::max(max_rank_error, std::abs((double) num_less - (double) weight) / n);
+    weight += item.second;
+    num_less_or_equal = num_less + 1;
+  }
+  if (num_less_or_equal < n) {
+    max_rank_error = std::max(max_rank_error, std::abs((double) num_less_or_equal - (double) weight) / n);
+  }
+  return max_rank_error;
+}
+
+} /* namespace datasketches */
+
+#endif /* KLL_RANK_ERROR_H_ */
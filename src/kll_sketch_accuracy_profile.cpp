@@ -4,30 +4,87 @@
  */
 
 #include "kll_sketch_accuracy_profile.h"
+#include "kll_rank_error.h"
+#include "characterization_utils.h"
+#include "trial_scheduler.h"
+#include "prefix_sweep.h"
+#include "fenwick_tree.h"
 
+#include <iostream>
 #include <algorithm>
 #include <random>
-#include <chrono>
+#include <memory>
+#include <vector>
 
 #include <kll_sketch.hpp>
 
 namespace datasketches {
 
-double kll_sketch_accuracy_profile::run_trial(float* values, unsigned stream_length) {
-  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-  std::shuffle(values, values + stream_length, std::default_random_engine(seed));
+kll_sketch_accuracy_profile::kll_sketch_accuracy_profile(bool incremental): incremental(incremental) {}
 
-  kll_sketch<float> sketch;
-  for (size_t i = 0; i < stream_length; i++) sketch.update(values[i]);
-
-  double max_rank_error = 0;
-  for (size_t i = 0; i < stream_length; i++) {
-    double true_rank = (double) i / stream_length;
-    double est_rank = sketch.get_rank(i);
-    max_rank_error = std::max(max_rank_error, abs(true_rank - est_rank));
+void kll_sketch_accuracy_profile::run(sweep_shard& shard) {
+  if (incremental) {
+    run_incremental(shard);
+  } else {
+    kll_accuracy_profile::run(shard);
   }
+}
+
+double kll_sketch_accuracy_profile::run_trial(float* values, unsigned stream_length, uint64_t seed) {
+  return run_kll_sketch_trial(values, stream_length, seed, kll_sketch<float>::DEFAULT_K);
+}
+
+// Each trial shuffles 0..max-1 once and feeds it into one sketch. A prefix of that stream is a random subset
+// rather than 0..n-1, so the true ranks at a checkpoint come from a Fenwick tree of the values fed so far.
+void kll_sketch_accuracy_profile::run_incremental(sweep_shard& shard) {
+  const unsigned lg_min(0);
+  const unsigned lg_max(23);
+  const unsigned ppo(16);
+  const unsigned num_trials(100);
+  const unsigned error_pct(99);
+
+  // trials are seeded from this, so the output does not depend on the number of threads
+  const uint64_t seed(get_run_seed());
 
-  return max_rank_error;
+  const prefix_sweep sweep(shard, lg_min, lg_max, ppo, [num_trials](size_t) { return num_trials; });
+  const size_t num_checkpoints = sweep.get_num_checkpoints();
+  if (num_checkpoints == 0) return;
+
+  // rank errors by checkpoint and trial
+  std::vector<double> rank_errors(num_checkpoints * num_trials);
+
+  // each worker owns a buffer of values and the ground truth
+  trial_scheduler scheduler;
+  const size_t max_len = sweep.get_stream_length(num_checkpoints - 1);
+  std::vector<std::unique_ptr<float[]>> values(scheduler.get_num_threads());
+  for (auto& buffer: values) buffer.reset(new float[max_len]);
+  std::vector<fenwick_tree> truth(scheduler.get_num_threads(), fenwick_tree(max_len));
+
+  scheduler.run(num_trials, [&](unsigned worker, size_t t) {
+    float* trial_values = values[worker].get();
+    for (unsigned i = 0; i < max_len; i++) trial_values[i] = i;
+    std::shuffle(trial_values, trial_values + max_len, std::default_random_engine(derive_seed(seed, max_len, t)));
+    truth[worker].clear();
+
+    kll_sketch<float> sketch;
+    size_t i = 0;
+    for (size_t checkpoint = 0; checkpoint < num_checkpoints; checkpoint++) {
+      const size_t stream_length = sweep.get_stream_length(checkpoint);
+      for (; i < stream_length; i++) {
+        sketch.update(trial_values[i]);
+        truth[worker].add((size_t) trial_values[i]);
+      }
+      rank_errors[checkpoint * num_trials + t] = kll_max_rank_error(sketch, truth[worker]);
+    }
+  });
+
+  for (size_t checkpoint = 0; checkpoint < num_checkpoints; checkpoint++) {
+    double* errors = &rank_errors[checkpoint * num_trials];
+    shard.add_row_samples({{"RankError", std::vector<double>(errors, errors + num_trials)}});
+    std::sort(errors, errors + num_trials);
+    const unsigned error_pct_index = num_trials * error_pct / 100;
+    shard.out() << sweep.get_stream_length(checkpoint) << "\t" << errors[error_pct_index] * 100 << std::endl;
+  }
 }
 
 } /* namespace datasketches */
@@ -6,13 +6,37 @@
 #ifndef KLL_SKETCH_ACCURACY_PROFILE_H_
 #define KLL_SKETCH_ACCURACY_PROFILE_H_
 
+#include <algorithm>
+#include <random>
+
+#include <kll_sketch.hpp>
+
 #include "kll_accuracy_profile.h"
+#include "kll_rank_error.h"
 
 namespace datasketches {
 
+// trial of kll-accuracy for any item type and k: the values shuffled with the seed into one sketch
+template<typename T, typename C = std::less<T>>
+double run_kll_sketch_trial(T* values, unsigned stream_length, uint64_t seed, uint16_t k) {
+  std::shuffle(values, values + stream_length, std::default_random_engine(seed));
+
+  kll_sketch<T, C> sketch(k);
+  for (size_t i = 0; i < stream_length; i++) sketch.update(values[i]);
+
+  return kll_max_rank_error(sketch, stream_length);
+}
+
 class kll_sketch_accuracy_profile: public kll_accuracy_profile {
 public:
-  virtual double run_trial(float* values, unsigned stream_length);
+  // incremental: one stream per trial evaluated at every point, instead of a fresh stream per point
+  explicit kll_sketch_accuracy_profile(bool incremental = false);
+  virtual void run(sweep_shard& shard);
+  virtual double run_trial(float* values, unsigned stream_length, uint64_t seed);
+
+private:
+  bool incremental;
+  void run_incremental(sweep_shard& shard);
 };
 
 } /* namespace datasketches */
@@ -4,122 +4,189 @@
  */
 
 #include "kll_sketch_timing_profile.h"
-#include "characterization_utils.h"
+#include "timing_profile.h"
+#include "trace_input.h"
+#include "counting_allocator.h"
+#include "kll_presorted_update.h"
+#include "kll_type_matrix.h"
 
-#include <iostream>
 #include <algorithm>
 #include <random>
-#include <chrono>
-#include <sstream>
+#include <limits>
+#include <type_traits>
 
 #include <kll_sketch.hpp>
 
 namespace datasketches {
 
-void kll_sketch_timing_profile::run() {
-  const size_t lg_min_stream_len(0);
-  const size_t lg_max_stream_len(23);
-  const size_t ppo(16);
+template<typename T, typename C>
+using kll_counted_sketch = kll_sketch<T, C, serde<T>, counting_allocator<T>>;
 
-  const size_t lg_max_trials(16);
-  const size_t lg_min_trials(6);
+// uniform in [0, 1) for floating point types, over the whole range for integers
+template<typename T>
+using uniform_item_distribution = typename std::conditional<std::is_floating_point<T>::value,
+    std::uniform_real_distribution<T>, std::uniform_int_distribution<T>>::type;
 
-  const size_t num_queries(20);
-
-  std::default_random_engine generator(std::chrono::system_clock::now().time_since_epoch().count());
-  std::uniform_real_distribution<float> distribution(0.0, 1.0);
-
-  std::cout << "Stream\tTrials\tBuild\tUpdate\tQuant\tQuants\tRank\tCDF\tSer\tDeser\tItems\tSize" << std::endl;
+template<typename T>
+uniform_item_distribution<T> make_uniform_item_distribution() {
+  return std::is_floating_point<T>::value ? uniform_item_distribution<T>(0, 1) :
+      uniform_item_distribution<T>(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+}
 
-  size_t max_len(1 << lg_max_stream_len);
-  float* values = new float[max_len];
+/*
+ * Ingestion of the trial items in blocks of each batch size through kll_presorted_updater,
+ * and per item into a sketch of its own in the same trial as the baseline, in nanoseconds per item like Update.
+ * The columns are PerItem and Presorted<batch size>, followed by the speedup of each batch size over PerItem.
+ */
+template<typename T, typename C>
+class presorted_update_timing {
+public:
+  explicit presorted_update_timing(uint16_t k): per_item_column("PerItem"), updater(k), k(k) {
+    for (size_t batch_size: batch_sizes) columns.push_back(timing_column("Presorted" + std::to_string(batch_size)));
+  }
+  void header(std::ostream& os) const {
+    os << "\t" << per_item_column.get_name();
+    for (const auto& column: columns) os << "\t" << column.get_name();
+    for (const auto& column: columns) os << "\t" << column.get_name() << "Speedup";
+  }
+  void add_columns(std::vector<timing_column*>& columns) {
+    columns.push_back(&per_item_column);
+    for (auto& column: this->columns) columns.push_back(&column);
+  }
+  void clear() {
+    per_item_column.clear();
+    for (auto& column: columns) column.clear();
+  }
+  void run(const kll_counted_sketch<T, C>&, const T* items, size_t stream_length) {
+    {
+      kll_counted_sketch<T, C> sketch(k);
+      const auto start(per_item_column.start());
+      for (size_t i = 0; i < stream_length; i++) sketch.update(items[i]);
+      per_item_column.stop(start, stream_length);
+      do_not_optimize(sketch.get_n());
+    }
+    for (size_t i = 0; i < NUM_BATCH_SIZES; i++) {
+      kll_counted_sketch<T, C> sketch(k);
+      const auto start(columns[i].start());
+      for (size_t offset = 0; offset < stream_length; offset += batch_sizes[i]) {
+        updater.update(sketch, items + offset, std::min(batch_sizes[i], stream_length - offset));
+      }
+      columns[i].stop(start, stream_length);
+      do_not_optimize(sketch.get_n());
+    }
+  }
+  void print(std::ostream& os, size_t) const {
+    os << "\t" << per_item_column.get_mean();
+    for (const auto& column: columns) os << "\t" << column.get_mean();
+    for (const auto& column: columns) os << "\t" << per_item_column.get_mean() / column.get_mean();
+  }
 
-  float rank_query_values[num_queries];
-  for (size_t i = 0; i < num_queries; i++) rank_query_values[i] = distribution(generator);
-  std::sort(&rank_query_values[0], &rank_query_values[num_queries]);
+private:
+  static const size_t NUM_BATCH_SIZES = 4;
+  const size_t batch_sizes[NUM_BATCH_SIZES] = {16, 256, 4096, 65536};
+  timing_column per_item_column;
+  std::vector<timing_column> columns;
+  kll_presorted_updater<T, C> updater;
+  uint16_t k;
+};
 
+/*
+ * The input is generated once and reused across runs, or replayed from a trace,
+ * each trial reads a different window of it.
+ * The query values are random, the rank queries are sorted as get_CDF() requires.
+ * The rank queries of a trace are random items of the trace, since its range is unknown.
+ * Entry is an item type of the type matrix (see kll_type_matrix.h), k is chosen at runtime.
+ */
+template<typename Entry>
+struct kll_timing_traits {
+  typedef typename Entry::item_type item_type;
+  typedef typename Entry::comparator comparator;
+  typedef kll_counted_sketch<item_type, comparator> sketch_type;
+  static const size_t lg_min_trials = 6;
+  static const size_t lg_max_trials = 16;
+
+  static const size_t num_queries = 20;
+  static const uint64_t dataset_seed = 1;
+  static const size_t dataset_length = 1 << 24;
+
+  uint16_t k;
+  timing_input<item_type> input;
+  item_type rank_query_values[num_queries];
   double quantile_query_values[num_queries];
-  for (size_t i = 0; i < num_queries; i++) quantile_query_values[i] = distribution(generator);
-
-  size_t stream_length(1 << lg_min_stream_len);
-  while (stream_length <= (1 << lg_max_stream_len)) {
-
-    std::chrono::nanoseconds build_time_ns(0);
-    std::chrono::nanoseconds update_time_ns(0);
-    std::chrono::nanoseconds get_quantile_time_ns(0);
-    std::chrono::nanoseconds get_quantiles_time_ns(0);
-    std::chrono::nanoseconds get_rank_time_ns(0);
-    std::chrono::nanoseconds get_cdf_time_ns(0);
-    std::chrono::nanoseconds serialize_time_ns(0);
-    std::chrono::nanoseconds deserialize_time_ns(0);
-    size_t num_retained(0);
-    size_t size_bytes(0);
-
-    const size_t num_trials = get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len, lg_min_trials, lg_max_trials);
-    for (size_t i = 0; i < num_trials; i++) {
-      for (size_t i = 0; i < stream_length; i++) values[i] = distribution(generator);
-
-      auto start_build(std::chrono::high_resolution_clock::now());
-      kll_sketch<float> sketch;
-      auto finish_build(std::chrono::high_resolution_clock::now());
-      build_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_build - start_build);
-
-      auto start_update(std::chrono::high_resolution_clock::now());
-      for (size_t i = 0; i < stream_length; i++) sketch.update(values[i]);
-      auto finish_update(std::chrono::high_resolution_clock::now());
-      update_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_update - start_update);
-
-      auto start_get_quantile(std::chrono::high_resolution_clock::now());
-      for (size_t i = 0; i < num_queries; i++) sketch.get_quantile(quantile_query_values[i]);
-      auto finish_get_quantile(std::chrono::high_resolution_clock::now());
-      get_quantile_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_get_quantile - start_get_quantile);
-
-      auto start_get_quantiles(std::chrono::high_resolution_clock::now());
-      sketch.get_quantiles(quantile_query_values, num_queries);
-      auto finish_get_quantiles(std::chrono::high_resolution_clock::now());
-      get_quantiles_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_get_quantiles - start_get_quantiles);
-
-      auto start_get_rank(std::chrono::high_resolution_clock::now());
-      for (size_t i = 0; i < num_queries; i++) {
-        volatile double rank = sketch.get_rank(rank_query_values[i]); // volatile to prevent this from being optimized away
+
+  explicit kll_timing_traits(uint16_t k = sketch_type::DEFAULT_K):
+  k(k),
+  input(std::string("uniform_") + Entry::dataset_name() + "_seed" + std::to_string(dataset_seed), dataset_length,
+      [](item_type* items, size_t num_items) {
+        std::default_random_engine generator(dataset_seed);
+        auto distribution = make_uniform_item_distribution<item_type>();
+        for (size_t i = 0; i < num_items; i++) items[i] = distribution(generator);
       }
-      auto finish_get_rank(std::chrono::high_resolution_clock::now());
-      get_rank_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_get_rank - start_get_rank);
-
-      auto start_get_cdf(std::chrono::high_resolution_clock::now());
-      sketch.get_CDF(rank_query_values, num_queries);
-      auto finish_get_cdf(std::chrono::high_resolution_clock::now());
-      get_cdf_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_get_cdf - start_get_cdf);
-
-      std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
-      auto start_serialize(std::chrono::high_resolution_clock::now());
-      sketch.serialize(s);
-      auto finish_serialize(std::chrono::high_resolution_clock::now());
-      serialize_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_serialize - start_serialize);
-
-      auto start_deserialize(std::chrono::high_resolution_clock::now());
-      auto sketch_ptr(kll_sketch<float>::deserialize(s));
-      auto finish_deserialize(std::chrono::high_resolution_clock::now());
-      deserialize_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(finish_deserialize - start_deserialize);
-
-      num_retained += sketch.get_num_retained();
-      size_bytes += s.tellp();
+  )
+  {
+    std::default_random_engine generator(get_run_seed());
+    auto item_distribution = make_uniform_item_distribution<item_type>();
+    std::uniform_real_distribution<float> distribution(0.0, 1.0);
+    std::uniform_int_distribution<size_t> index_distribution(0, input.size() - 1);
+    for (size_t i = 0; i < num_queries; i++) {
+      rank_query_values[i] = input.is_trace() ? input.data()[index_distribution(generator)] : item_distribution(generator);
     }
-    std::cout << stream_length << "\t"
-        << num_trials << "\t"
-        << (double) build_time_ns.count() / num_trials << "\t"
-        << (double) update_time_ns.count() / num_trials / stream_length << "\t"
-        << (double) get_quantile_time_ns.count() / num_trials / num_queries << "\t"
-        << (double) get_quantiles_time_ns.count() / num_trials / num_queries << "\t"
-        << (double) get_rank_time_ns.count() / num_trials / num_queries << "\t"
-        << (double) get_cdf_time_ns.count() / num_trials / num_queries << "\t"
-        << (double) serialize_time_ns.count() / num_trials << "\t"
-        << (double) deserialize_time_ns.count() / num_trials << "\t"
-        << num_retained / num_trials << "\t"
-        << size_bytes / num_trials << std::endl;
-    stream_length = pwr_2_law_next(ppo, stream_length);
+    std::sort(&rank_query_values[0], &rank_query_values[num_queries], comparator());
+    for (size_t i = 0; i < num_queries; i++) quantile_query_values[i] = distribution(generator);
+  }
+
+  sketch_type build() { return sketch_type(k); }
+
+  const item_type* get_items(size_t stream_length, size_t trial) {
+    return input.get_items(stream_length, trial);
   }
-  delete [] values;
+
+  auto make_operations() {
+    const auto serialize_stream = [](const sketch_type& sketch, std::ostream& os) { sketch.serialize(os); };
+    const auto deserialize_bytes = [](const void* bytes, size_t size) { return sketch_type::deserialize(bytes, size); };
+    return std::make_tuple(
+      make_query_timing("Quant", [this](const sketch_type& sketch) {
+        for (size_t i = 0; i < num_queries; i++) do_not_optimize(sketch.get_quantile(quantile_query_values[i]));
+      }, num_queries),
+      make_query_timing("Quants", [this](const sketch_type& sketch) {
+        do_not_optimize(sketch.get_quantiles(quantile_query_values, num_queries));
+      }, num_queries),
+      make_query_timing("Rank", [this](const sketch_type& sketch) {
+        for (size_t i = 0; i < num_queries; i++) do_not_optimize(sketch.get_rank(rank_query_values[i]));
+      }, num_queries),
+      make_query_timing("CDF", [this](const sketch_type& sketch) {
+        do_not_optimize(sketch.get_CDF(rank_query_values, num_queries));
+      }, num_queries),
+      make_stream_serde_timing("Ser", "Deser", serialize_stream,
+          [](std::istream& is) { return sketch_type::deserialize(is); }),
+      make_statistic("Items", [](const sketch_type& sketch) { return sketch.get_num_retained(); }),
+      make_statistic("Size", get_serialized_size_bytes<sketch_type>),
+      make_bytes_serde_timing("SerBytes", "DeserBytes",
+          [](const sketch_type& sketch) { return sketch.serialize(); }, deserialize_bytes),
+      make_buffer_serde_timing("SerBuf", "DeserBuf", serialize_stream, deserialize_bytes),
+      make_mapped_serde_timing("SerMap", "DeserMap", serialize_stream, deserialize_bytes),
+      presorted_update_timing<item_type, comparator>(k)
+    );
+  }
+};
+
+kll_sketch_timing_profile::kll_sketch_timing_profile(bool matrix): matrix(matrix) {}
+
+// the matrix runs a section per item type and k, with the columns of the float profile
+void kll_sketch_timing_profile::run(sweep_shard& shard) {
+  if (!matrix) {
+    timing_profile<kll_timing_traits<kll_float_entry>>().run(shard);
+    return;
+  }
+  const std::vector<uint16_t> k_values = get_kll_matrix_k_values();
+  for_each_type(kll_matrix_types(), [&shard, &k_values](auto entry) {
+    typedef decltype(entry) entry_type;
+    for (uint16_t k: k_values) {
+      shard.begin_section(get_kll_matrix_section<entry_type>(k));
+      kll_timing_traits<entry_type> traits(k);
+      run_timing_sweep(shard, traits);
+    }
+  });
 }
 
 } /* namespace datasketches */
@@ -6,11 +6,21 @@
 #ifndef KLL_SKETCH_TIMING_PROFILE_H_
 #define KLL_SKETCH_TIMING_PROFILE_H_
 
+#include "profile.h"
+
 namespace datasketches {
 
-class kll_sketch_timing_profile {
+/*
+ * Timing of kll_sketch<float> with the default k, or with matrix set, of every item type of kll_matrix_types
+ * with every k from get_kll_matrix_k_values(), each in its own section.
+ */
+class kll_sketch_timing_profile: public profile {
 public:
-  virtual void run();
+  explicit kll_sketch_timing_profile(bool matrix = false);
+  virtual void run(sweep_shard& shard);
+
+private:
+  bool matrix;
 };
 
 } /* namespace datasketches */
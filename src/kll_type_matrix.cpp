@@ -0,0 +1,30 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "kll_type_matrix.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include <kll_sketch.hpp>
+
+namespace datasketches {
+
+std::vector<uint16_t> get_kll_matrix_k_values() {
+  const char* env = getenv("CHARACTERIZATION_KLL_K");
+  if (env == nullptr || *env == 0) return {kll_sketch<float>::DEFAULT_K};
+  std::vector<uint16_t> k_values;
+  std::istringstream is(env);
+  std::string field;
+  while (std::getline(is, field, ',')) {
+    const int k = atoi(field.c_str());
+    if (k < 8 || k > 65535) throw std::invalid_argument("invalid KLL k: " + field);
+    k_values.push_back(k);
+  }
+  return k_values;
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef KLL_TYPE_MATRIX_H_
+#define KLL_TYPE_MATRIX_H_
+
+#include <cstdint>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace datasketches {
+
+// orders NaN after all numbers, as for latencies with missing measurements, otherwise the same as std::less
+struct nan_last_less {
+  bool operator()(double a, double b) const {
+    return a < b || (!std::isnan(a) && std::isnan(b));
+  }
+};
+
+/*
+ * Item types of the KLL type matrix: the item, the comparator, the name of the section
+ * and the name of the generated dataset (the same for entries that differ only by comparator).
+ */
+template<typename T, typename C = std::less<T>>
+struct kll_matrix_entry {
+  typedef T item_type;
+  typedef C comparator;
+};
+
+struct kll_float_entry: kll_matrix_entry<float> {
+  static const char* name() { return "float"; }
+  static const char* dataset_name() { return "float_0_1"; }
+};
+
+struct kll_double_entry: kll_matrix_entry<double> {
+  static const char* name() { return "double"; }
+  static const char* dataset_name() { return "double_0_1"; }
+};
+
+struct kll_int64_entry: kll_matrix_entry<int64_t> {
+  static const char* name() { return "int64_t"; }
+  static const char* dataset_name() { return "int64"; }
+};
+
+struct kll_latency_entry: kll_matrix_entry<double, nan_last_less> {
+  static const char* name() { return "double,nan_last_less"; }
+  static const char* dataset_name() { return "double_0_1"; }
+};
+
+template<typename... Entries>
+struct type_list {};
+
+typedef type_list<kll_float_entry, kll_double_entry, kll_int64_entry, kll_latency_entry> kll_matrix_types;
+
+// calls fn(Entry()) for every type of the list in order
+template<typename Fn>
+void for_each_type(type_list<>, Fn&&) {}
+
+template<typename Entry, typename... Entries, typename Fn>
+void for_each_type(type_list<Entry, Entries...>, Fn&& fn) {
+  fn(Entry());
+  for_each_type(type_list<Entries...>(), fn);
+}
+
+// values of k for the type matrix: comma separated in the environment variable CHARACTERIZATION_KLL_K,
+// otherwise the default k of the sketch
+std::vector<uint16_t> get_kll_matrix_k_values();
+
+// name of the section of an item type and k
+template<typename Entry>
+std::string get_kll_matrix_section(uint16_t k) {
+  return std::string("kll_sketch<") + Entry::name() + "> k=" + std::to_string(k);
+}
+
+} /* namespace datasketches */
+
+#endif /* KLL_TYPE_MATRIX_H_ */
@@ -5,39 +5,258 @@
 
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
 
 #include "kll_sketch_accuracy_profile.h"
 #include "kll_sketch_timing_profile.h"
 #include "kll_merge_accuracy_profile.h"
+#include "kll_matrix_accuracy_profile.h"
+#include "kll_merge_timing_profile.h"
 #include "cpc_sketch_timing_profile.h"
+#include "cpc_sketch_accuracy_profile.h"
+#include "cpc_union_timing_profile.h"
+#include "hll_sketch_timing_profile.h"
+#include "theta_sketch_timing_profile.h"
 #include "frequent_items_sketch_timing_profile.h"
 #include "frequent_items_sketch_accuracy_profile.h"
+#include "frequent_strings_timing_profile.h"
+#include "concurrent_serving_profile.h"
+#include "sweep_runner.h"
+#include "results_comparison.h"
+#include "cpu_isolation.h"
+
+static std::unique_ptr<datasketches::profile> make_profile(const char* command) {
+  if (strcmp(command, "kll-accuracy") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::kll_sketch_accuracy_profile());
+  } else if (strcmp(command, "kll-accuracy-incremental") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::kll_sketch_accuracy_profile(true));
+  } else if (strcmp(command, "kll-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::kll_sketch_timing_profile());
+  } else if (strcmp(command, "kll-matrix-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::kll_sketch_timing_profile(true));
+  } else if (strcmp(command, "kll-matrix-accuracy") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::kll_matrix_accuracy_profile());
+  } else if (strcmp(command, "kll-merge-accuracy") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::kll_merge_accuracy_profile());
+  } else if (strcmp(command, "kll-merge-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::kll_merge_timing_profile());
+  } else if (strcmp(command, "cpc-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::cpc_sketch_timing_profile());
+  } else if (strcmp(command, "cpc-accuracy") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::cpc_sketch_accuracy_profile());
+  } else if (strcmp(command, "cpc-accuracy-incremental") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::cpc_sketch_accuracy_profile(true));
+  } else if (strcmp(command, "cpc-union-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::cpc_union_timing_profile());
+  } else if (strcmp(command, "hll-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::hll_sketch_timing_profile(datasketches::HLL_4));
+  } else if (strcmp(command, "hll6-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::hll_sketch_timing_profile(datasketches::HLL_6));
+  } else if (strcmp(command, "hll8-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::hll_sketch_timing_profile(datasketches::HLL_8));
+  } else if (strcmp(command, "theta-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::theta_sketch_timing_profile());
+  } else if (strcmp(command, "fi-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::frequent_items_sketch_timing_profile());
+  } else if (strcmp(command, "fi-string-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::frequent_strings_timing_profile(false));
+  } else if (strcmp(command, "fi-string-arena-timing") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::frequent_strings_timing_profile(true));
+  } else if (strcmp(command, "fi-accuracy") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::frequent_items_sketch_accuracy_profile());
+  } else if (strcmp(command, "fi-accuracy-incremental") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::frequent_items_sketch_accuracy_profile(true));
+  } else if (strcmp(command, "kll-serving") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::concurrent_serving_profile(datasketches::concurrent_serving_profile::KLL));
+  } else if (strcmp(command, "fi-serving") == 0) {
+    return std::unique_ptr<datasketches::profile>(new datasketches::concurrent_serving_profile(datasketches::concurrent_serving_profile::FREQUENT_ITEMS));
+  }
+  return nullptr;
+}
+
+static void print_usage() {
+  std::cerr << "Usage: characterization <command> [options]" << std::endl
+      << "Commands: kll-accuracy, kll-timing, kll-merge-accuracy, kll-merge-timing, cpc-timing," << std::endl
+      << "          cpc-accuracy, cpc-union-timing, hll-timing (HLL_4), hll6-timing, hll8-timing," << std::endl
+      << "          theta-timing, fi-timing, fi-accuracy," << std::endl
+      << "          fi-string-timing, fi-string-arena-timing (std::string keys or keys in a per-sketch arena)" << std::endl
+      << "          kll-matrix-timing, kll-matrix-accuracy: a section per item type (float, double, int64_t," << std::endl
+      << "            double with a custom comparator) and per k of --k" << std::endl
+      << "          kll-accuracy-incremental, cpc-accuracy-incremental, fi-accuracy-incremental:" << std::endl
+      << "            one stream per trial evaluated at every stream length (single sketch for fi)" << std::endl
+      << "          kll-serving, fi-serving: one writer and 1, 2, 4... readers sharing a sketch, a section" << std::endl
+      << "            per scheme (mutex, reader-writer lock, atomically published snapshots)" << std::endl
+      << "Options:" << std::endl
+      << "  --shards <n>  split the sweep into n shards run as separate processes," << std::endl
+      << "                rows are checkpointed in --dir and finished points are skipped on restart" << std::endl
+      << "  --dir <path>  directory for shard files (default: sweep)" << std::endl
+      << "  --shard <i>   run only shard i of n in this process (for example on another machine)" << std::endl
+      << "  --merge       only merge existing shard files" << std::endl
+      << "  --json <path> also write JSON lines: the run metadata (CPU, compiler, flags, library version, seed)," << std::endl
+      << "                then a record per row with the raw samples of the trials" << std::endl
+      << "  --seed <n>    base seed of the random inputs, to reproduce a run (default: from the clock," << std::endl
+      << "                recorded in the metadata of --json)" << std::endl
+      << "  --k <k,...>   values of k for the KLL type matrix (default: 200)" << std::endl
+      << "  --trace <path> replay a trace instead of the generated input of kll-timing, fi-timing and the" << std::endl
+      << "                distinct count timings: a dataset cache file, raw native items in a .bin file," << std::endl
+      << "                or one item per line (keys that are not numbers are hashed)" << std::endl
+      << "  --cpus <list> pin the main thread and the worker threads to these CPUs (for example 2-5,8)" << std::endl
+      << "                and bind memory to their NUMA nodes, each shard started by --shards takes its own" << std::endl
+      << "                part of the list" << std::endl
+      << "  --perf-counters also report hardware counters per operation (cycles, instructions, L1D and LLC" << std::endl
+      << "                misses, branch misses), n/a where the counters never ran, scaled if multiplexed" << std::endl
+      << "  --strict      refuse to run if the CPUs are not pinned, SMT siblings are in use, there are more" << std::endl
+      << "                shards than pinned CPUs, or frequency scaling, turbo or a governor other than" << std::endl
+      << "                performance is detected (otherwise warns);" << std::endl
+      << "                the detected state is in the metadata of --json" << std::endl
+      << "Environment:" << std::endl
+      << "  CHARACTERIZATION_SEED           same as --seed" << std::endl
+      << "  CHARACTERIZATION_DATASET_CACHE  directory of the generated input datasets (default: dataset_cache)," << std::endl
+      << "                                  reused across runs" << std::endl
+      << "Usage: characterization compare <baseline.tsv> <new.tsv> [options]" << std::endl
+      << "  compares the timing columns of two results, exits with 2 if any of them got slower" << std::endl
+      << "  --threshold <percent>  smallest change reported as a regression (default: 5)" << std::endl
+      << "  --alpha <p>            significance level (default: 0.01)" << std::endl
+      << "  --section <name>       the section to compare in results with sections (kll-matrix, serving)" << std::endl
+      << "  --columns <a,b...>     columns to compare instead of the timing columns, lower is better;" << std::endl
+      << "                         column3, column4... in results without a header (required if neither has one)" << std::endl;
+}
+
+static int compare(int argc, char **argv) {
+  if (argc < 4) {
+    print_usage();
+    return 1;
+  }
+  double threshold = 5;
+  double alpha = 0.01;
+  std::string section;
+  std::vector<std::string> columns;
+  for (int i = 4; i < argc; i++) {
+    if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) {
+      alpha = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--section") == 0 && i + 1 < argc) {
+      section = argv[++i];
+    } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) {
+      std::istringstream list(argv[++i]);
+      std::string column;
+      while (std::getline(list, column, ',')) if (!column.empty()) columns.push_back(column);
+    } else {
+      std::cerr << "Unsupported option " << argv[i] << std::endl;
+      print_usage();
+      return 1;
+    }
+  }
+  try {
+    const auto baseline = datasketches::results_table::load(argv[2], section);
+    const auto current = datasketches::results_table::load(argv[3], section);
+    datasketches::results_comparison comparison(threshold / 100, alpha, columns);
+    return comparison.compare(baseline, current, std::cout) ? 2 : 0;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}
 
 int main(int argc, char **argv) {
-  if (argc == 2) {
-    if (strcmp(argv[1], "kll-accuracy") == 0) {
-      datasketches::kll_sketch_accuracy_profile profile;
-      profile.run();
-    } else if (strcmp(argv[1], "kll-timing") == 0) {
-      datasketches::kll_sketch_timing_profile profile;
-      profile.run();
-    } else if (strcmp(argv[1], "kll-merge-accuracy") == 0) {
-      datasketches::kll_merge_accuracy_profile profile;
-      profile.run();
-    } else if (strcmp(argv[1], "cpc-timing") == 0) {
-      datasketches::cpc_sketch_timing_profile profile;
-      profile.run();
-    } else if (strcmp(argv[1], "fi-timing") == 0) {
-      datasketches::frequent_items_sketch_timing_profile profile;
-      profile.run();
-    } else if (strcmp(argv[1], "fi-accuracy") == 0) {
-      datasketches::frequent_items_sketch_accuracy_profile profile;
-      profile.run();
+  if (argc < 2) {
+    print_usage();
+    return 1;
+  }
+  if (strcmp(argv[1], "compare") == 0) return compare(argc, argv);
+  std::unique_ptr<datasketches::profile> profile = make_profile(argv[1]);
+  if (!profile) {
+    std::cerr << "Unsupported command " << argv[1] << std::endl;
+    print_usage();
+    return 1;
+  }
+
+  unsigned num_shards = 0;
+  int shard_index = -1;
+  std::string directory = "sweep";
+  bool merge_only = false;
+  std::string json_path;
+  bool strict = false;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+      num_shards = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+      directory = argv[++i];
+    } else if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+      shard_index = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--merge") == 0) {
+      merge_only = true;
+    } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json_path = argv[++i];
+    } else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc) {
+      setenv("CHARACTERIZATION_KLL_K", argv[++i], 1);
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      // through the environment, so that shard processes and the metadata see it as well
+      setenv("CHARACTERIZATION_TRACE", argv[++i], 1);
+    } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+      setenv("CHARACTERIZATION_CPUS", argv[++i], 1);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      setenv("CHARACTERIZATION_SEED", argv[++i], 1);
+    } else if (strcmp(argv[i], "--perf-counters") == 0) {
+      setenv("CHARACTERIZATION_PERF_COUNTERS", "1", 1);
+    } else if (strcmp(argv[i], "--strict") == 0) {
+      strict = true;
     } else {
-      std::cerr << "Unsupported command " << argv[1] << std::endl;
+      std::cerr << "Unsupported option " << argv[i] << std::endl;
+      print_usage();
+      return 1;
+    }
+  }
+
+  if (num_shards == 0 && (shard_index >= 0 || merge_only)) {
+    std::cerr << "--shard and --merge require --shards" << std::endl;
+    return 1;
+  }
+
+  try {
+    auto metadata = datasketches::run_metadata::collect(argc, argv);
+    const size_t num_cpus = datasketches::get_pinned_cpus().size();
+    if (num_shards > 0 && shard_index < 0 && !merge_only && num_cpus > 0 && num_shards > num_cpus) {
+      metadata.cpu.warnings.push_back(std::to_string(num_shards) + " shards share " + std::to_string(num_cpus) + " pinned CPUs");
+    }
+    for (const auto& warning: metadata.cpu.warnings) std::cerr << "Warning: " << warning << std::endl;
+    if (strict && !metadata.cpu.warnings.empty()) {
+      std::cerr << "Refusing to run with --strict" << std::endl;
+      return 1;
+    }
+    // shard processes started by --shards then take their own part of the pinned CPUs
+    datasketches::pin_thread(0);
+    datasketches::bind_memory_to_pinned_cpus();
+    if (num_shards == 0) {
+      datasketches::sweep_shard shard;
+      if (!json_path.empty()) shard.enable_json(json_path, metadata);
+      profile->run(shard);
+      return 0;
+    }
+    auto run_shard = [&profile](datasketches::sweep_shard& shard) { profile->run(shard); };
+    datasketches::sweep_runner runner(num_shards, directory);
+    if (!json_path.empty()) runner.enable_json(metadata);
+    if (shard_index >= 0) {
+      runner.run_shard(shard_index, run_shard);
+      return 0;
+    }
+    if (!merge_only && !runner.run(run_shard)) return 1;
+    runner.merge(std::cout);
+    if (!json_path.empty()) {
+      std::ofstream json(json_path);
+      if (!json) throw std::runtime_error("cannot open " + json_path);
+      runner.merge_json(json);
     }
-  } else {
-    std::cerr << "One parameter expected: kll-accuracy, kll-timing or kll-merge-accuracy" << std::endl;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
   }
   return 0;
 }
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "perf_counters.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace datasketches {
+
+static bool is_requested() {
+  static const bool requested = getenv("CHARACTERIZATION_PERF_COUNTERS") != nullptr;
+  return requested;
+}
+
+bool perf_counters::is_enabled() {
+  if (!is_requested()) return false;
+  static const bool enabled = get_instance().num_open > 0;
+  return enabled;
+}
+
+perf_counters::values perf_counters::read() {
+  if (!is_enabled()) return values();
+  return get_instance().read_group();
+}
+
+bool perf_counters::get_region_counts(const values& start, const values& finish, double counts[NUM_COUNTERS]) {
+  const uint64_t time_enabled = finish.time_enabled - start.time_enabled;
+  const uint64_t time_running = finish.time_running - start.time_running;
+  if (time_running == 0) return false;
+  const double scale = (double) time_enabled / time_running;
+  if (time_running < time_enabled) {
+    static bool warned = false;
+    if (!warned) {
+      std::cerr << "Warning: hardware counters are multiplexed with other perf users, the counts are scaled estimates" << std::endl;
+      warned = true;
+    }
+  }
+  for (unsigned i = 0; i < NUM_COUNTERS; i++) counts[i] = (finish.counts[i] - start.counts[i]) * scale;
+  return true;
+}
+
+const char* perf_counters::get_name(unsigned counter) {
+  static const char* names[NUM_COUNTERS] = {"Cycles", "Instr", "L1DMiss", "LLCMiss", "BrMiss"};
+  return names[counter];
+}
+
+perf_counters& perf_counters::get_instance() {
+  static thread_local perf_counters instance;
+  return instance;
+}
+
+#ifdef __linux__
+
+perf_counters::perf_counters(): leader_fd(-1), num_open(0) {
+  struct event { uint32_t type; uint64_t config; };
+  const event events[NUM_COUNTERS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+  };
+  for (unsigned i = 0; i < NUM_COUNTERS; i++) {
+    fds[i] = -1;
+    if (!is_requested()) continue;
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[i].type;
+    attr.config = events[i].config;
+    attr.disabled = leader_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, leader_fd, 0);
+    if (fds[i] == -1) continue;
+    if (leader_fd == -1) leader_fd = fds[i];
+    open_counters[num_open++] = i;
+  }
+  if (is_requested()) {
+    if (leader_fd == -1) {
+      std::cerr << "perf_event_open failed: " << strerror(errno) << ", hardware counters are not reported" << std::endl;
+    } else {
+      ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+}
+
+perf_counters::~perf_counters() {
+  for (unsigned i = 0; i < NUM_COUNTERS; i++) if (fds[i] != -1) close(fds[i]);
+}
+
+perf_counters::values perf_counters::read_group() const {
+  values result = values();
+  uint64_t buffer[3 + NUM_COUNTERS]; // number of counters, time enabled and running, followed by the counts
+  if (leader_fd == -1 || ::read(leader_fd, buffer, sizeof(buffer)) <= 0) return result;
+  result.time_enabled = buffer[1];
+  result.time_running = buffer[2];
+  for (unsigned i = 0; i < num_open && i < buffer[0]; i++) result.counts[open_counters[i]] = buffer[3 + i];
+  return result;
+}
+
+#else
+
+perf_counters::perf_counters(): leader_fd(-1), num_open(0) {
+  for (unsigned i = 0; i < NUM_COUNTERS; i++) fds[i] = -1;
+  if (is_requested()) std::cerr << "hardware counters are only supported on Linux" << std::endl;
+}
+
+perf_counters::~perf_counters() {}
+
+perf_counters::values perf_counters::read_group() const {
+  return values();
+}
+
+#endif
+
+} /* namespace datasketches */
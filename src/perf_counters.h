@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <cstdint>
+
+namespace datasketches {
+
+/*
+ * Hardware performance counters of the calling thread (Linux perf_event_open).
+ * Counting is off unless the CHARACTERIZATION_PERF_COUNTERS environment variable is set (by --perf-counters),
+ * because reading the counters costs a system call, and because access may be restricted
+ * by /proc/sys/kernel/perf_event_paranoid. Counters that the CPU does not support read as zero.
+ * If the group had to share the hardware with other users (multiplexing), the counts of a region are scaled
+ * by the time the group was enabled over the time it was running, with a warning, and a region during which
+ * the group never ran has no counts.
+ */
+class perf_counters {
+public:
+  enum counter { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, NUM_COUNTERS };
+
+  struct values {
+    uint64_t counts[NUM_COUNTERS];
+    uint64_t time_enabled;
+    uint64_t time_running;
+  };
+
+  // true if requested and at least one counter could be opened
+  static bool is_enabled();
+
+  // current counts of the calling thread, all zeros if not enabled
+  static values read();
+
+  // counts of the region between two reads, scaled if multiplexed, false if the group never ran in the region
+  static bool get_region_counts(const values& start, const values& finish, double counts[NUM_COUNTERS]);
+
+  static const char* get_name(unsigned counter);
+
+  ~perf_counters();
+
+private:
+  int leader_fd;
+  int fds[NUM_COUNTERS];
+  unsigned num_open; // counters opened successfully, in the order of the group
+  unsigned open_counters[NUM_COUNTERS];
+
+  perf_counters();
+  static perf_counters& get_instance(); // one per thread
+  values read_group() const;
+};
+
+} /* namespace datasketches */
+
+#endif /* PERF_COUNTERS_H_ */
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "prefix_sweep.h"
+#include "characterization_utils.h"
+
+#include <stdexcept>
+
+namespace datasketches {
+
+prefix_sweep::prefix_sweep(sweep_shard& shard, size_t lg_min, size_t lg_max, size_t ppo,
+    const std::function<size_t(size_t)>& get_num_trials) {
+  const size_t num_points = count_points(lg_min, lg_max, ppo);
+  size_t stream_length = 1 << lg_min;
+  for (size_t i = 0; i < num_points; i++, stream_length = pwr_2_law_next(ppo, stream_length)) {
+    if (!shard.should_run(stream_length)) continue;
+    const size_t trials = get_num_trials(stream_length);
+    if (!num_trials.empty() && trials > num_trials.back()) {
+      throw std::invalid_argument("number of trials must not increase with stream length");
+    }
+    stream_lengths.push_back(stream_length);
+    num_trials.push_back(trials);
+  }
+}
+
+size_t prefix_sweep::get_num_checkpoints(size_t trial) const {
+  size_t checkpoints = 0;
+  while (checkpoints < num_trials.size() && num_trials[checkpoints] > trial) checkpoints++;
+  return checkpoints;
+}
+
+size_t prefix_sweep::get_max_stream_length(size_t trial) const {
+  const size_t checkpoints = get_num_checkpoints(trial);
+  return checkpoints == 0 ? 0 : stream_lengths[checkpoints - 1];
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef PREFIX_SWEEP_H_
+#define PREFIX_SWEEP_H_
+
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+#include "sweep_shard.h"
+
+namespace datasketches {
+
+/*
+ * Plan of an incremental sweep, where every trial feeds one long stream into one sketch and evaluates it
+ * at checkpoints, the points of the sweep that the shard needs, instead of building a fresh sketch per point.
+ * The number of trials may decrease with the stream length, so trial t only goes as far as the last checkpoint
+ * that has more than t trials. The checkpoints of a trial are therefore always the first ones.
+ * Results are only known when all trials are done, so a profile writes all of its rows at the end,
+ * and a restarted shard computes its remaining points again from the beginning of the stream.
+ */
+class prefix_sweep {
+public:
+  // calls shard.should_run() for every point of the sweep,
+  // get_num_trials gives the number of trials of a stream length and must not increase with it
+  prefix_sweep(sweep_shard& shard, size_t lg_min, size_t lg_max, size_t ppo,
+      const std::function<size_t(size_t)>& get_num_trials);
+
+  size_t get_num_checkpoints() const { return stream_lengths.size(); }
+  size_t get_stream_length(size_t checkpoint) const { return stream_lengths[checkpoint]; }
+  size_t get_num_trials(size_t checkpoint) const { return num_trials[checkpoint]; }
+
+  // trials to run, the most trials of any checkpoint
+  size_t get_max_trials() const { return num_trials.empty() ? 0 : num_trials.front(); }
+
+  // number of checkpoints evaluated by the given trial
+  size_t get_num_checkpoints(size_t trial) const;
+
+  // length of the stream fed by the given trial
+  size_t get_max_stream_length(size_t trial) const;
+
+private:
+  std::vector<size_t> stream_lengths;
+  std::vector<size_t> num_trials;
+};
+
+} /* namespace datasketches */
+
+#endif /* PREFIX_SWEEP_H_ */
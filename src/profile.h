@@ -0,0 +1,26 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include "sweep_shard.h"
+
+namespace datasketches {
+
+/*
+ * A characterization profile sweeps over stream lengths and produces one row per point.
+ * It must call shard.should_run() for every point in order, compute only the points for which it returns true,
+ * and write the column names to shard.header() and the rows to shard.out().
+ */
+class profile {
+public:
+  virtual ~profile() {}
+  virtual void run(sweep_shard& shard) = 0;
+};
+
+} /* namespace datasketches */
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "results_comparison.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace datasketches {
+
+static std::vector<std::string> split_tabs(const std::string& line) {
+  std::vector<std::string> fields;
+  std::istringstream is(line);
+  std::string field;
+  while (std::getline(is, field, '\t')) fields.push_back(field);
+  // some stored results have a trailing tab
+  while (!fields.empty() && fields.back().empty()) fields.pop_back();
+  return fields;
+}
+
+static bool parse_number(const std::string& field, double& value) {
+  const char* begin = field.c_str();
+  char* end;
+  value = strtod(begin, &end);
+  return end != begin;
+}
+
+results_table results_table::load(const std::string& path, const std::string& section) {
+  std::ifstream is(path);
+  if (!is) throw std::runtime_error("cannot open " + path);
+  results_table table;
+  table.num_key_columns = 1;
+  std::string line;
+  std::string current_section;
+  std::string sections;
+  bool has_section = false;
+  while (std::getline(is, line)) {
+    if (line.compare(0, 2, "# ") == 0) {
+      current_section = line.substr(2);
+      sections += (sections.empty() ? "" : ", ") + current_section;
+      if (current_section == section) has_section = true;
+      continue;
+    }
+    if (current_section != section) continue;
+    const std::vector<std::string> fields = split_tabs(line);
+    if (fields.empty()) continue;
+    double first;
+    if (!parse_number(fields[0], first)) {
+      if (table.names.empty() && table.rows.empty()) {
+        table.names = fields;
+        const int trials = table.find("Trials");
+        if (trials > 0) table.num_key_columns = trials;
+        continue;
+      }
+      throw std::runtime_error("unexpected line in " + path + ": " + line);
+    }
+    if (fields.size() < table.num_key_columns) throw std::runtime_error("unexpected line in " + path + ": " + line);
+    std::string key = fields[0];
+    for (size_t i = 1; i < table.num_key_columns; i++) key += "\t" + fields[i];
+    if (table.row_index.count(key) > 0) {
+      throw std::runtime_error("more than one row for " + key + " in " + path
+          + (table.has_header() ? "" : " (without a header rows are identified by the first column)"));
+    }
+    std::vector<double> values(fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+      if (!parse_number(fields[i], values[i])) values[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+    table.row_index[key] = table.rows.size();
+    table.rows.push_back(std::make_pair(key, values));
+  }
+  if (section.empty() && !sections.empty()) throw std::runtime_error(path + " has sections, choose one with --section: " + sections);
+  if (!section.empty() && !has_section) throw std::runtime_error("no section " + section + " in " + path);
+  if (table.rows.empty()) throw std::runtime_error("no rows in " + path);
+  return table;
+}
+
+int results_table::find(const std::string& name) const {
+  for (size_t i = 0; i < names.size(); i++) {
+    if (names[i] == name) return i;
+  }
+  if (!has_header() && name.compare(0, 6, "column") == 0) {
+    const int position = atoi(name.c_str() + 6);
+    if (position > 0) return position - 1;
+  }
+  return -1;
+}
+
+// continued fraction of the incomplete beta function (modified Lentz's method)
+static double incomplete_beta_fraction(double a, double b, double x) {
+  const unsigned max_iterations = 300;
+  const double epsilon = 1e-14;
+  const double tiny = 1e-300;
+  double c = 1;
+  double d = 1 - (a + b) * x / (a + 1);
+  if (std::abs(d) < tiny) d = tiny;
+  d = 1 / d;
+  double h = d;
+  for (unsigned m = 1; m <= max_iterations; m++) {
+    const double m2 = 2 * m;
+    double aa = m * (b - m) * x / ((a + m2 - 1) * (a + m2));
+    d = 1 + aa * d;
+    if (std::abs(d) < tiny) d = tiny;
+    c = 1 + aa / c;
+    if (std::abs(c) < tiny) c = tiny;
+    d = 1 / d;
+    h *= d * c;
+    aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1));
+    d = 1 + aa * d;
+    if (std::abs(d) < tiny) d = tiny;
+    c = 1 + aa / c;
+    if (std::abs(c) < tiny) c = tiny;
+    d = 1 / d;
+    const double delta = d * c;
+    h *= delta;
+    if (std::abs(delta - 1) < epsilon) break;
+  }
+  return h;
+}
+
+// regularized incomplete beta function I_x(a, b)
+static double incomplete_beta(double a, double b, double x) {
+  if (x <= 0) return 0;
+  if (x >= 1) return 1;
+  const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1 - x));
+  if (x < (a + 1) / (a + b + 2)) return front * incomplete_beta_fraction(a, b, x) / a;
+  return 1 - front * incomplete_beta_fraction(b, a, 1 - x) / b;
+}
+
+double student_t_p_value(double t, double degrees_of_freedom) {
+  if (std::isnan(t) || degrees_of_freedom <= 0) return 1;
+  if (std::isinf(t)) return 0;
+  return incomplete_beta(degrees_of_freedom / 2, 0.5, degrees_of_freedom / (degrees_of_freedom + t * t));
+}
+
+// Welch's t-test of two means given the standard deviations and the numbers of samples
+static double welch_p_value(double mean1, double stddev1, double n1, double mean2, double stddev2, double n2) {
+  if (n1 < 2 || n2 < 2) return 1;
+  const double v1 = stddev1 * stddev1 / n1;
+  const double v2 = stddev2 * stddev2 / n2;
+  if (v1 + v2 == 0) return mean1 == mean2 ? 1 : 0;
+  const double t = (mean2 - mean1) / std::sqrt(v1 + v2);
+  const double df = (v1 + v2) * (v1 + v2) / (v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1));
+  return student_t_p_value(t, df);
+}
+
+struct compared_column {
+  std::string name;
+  int baseline_index;
+  int current_index;
+  int baseline_stddev_index;
+  int current_stddev_index;
+};
+
+// names of the columns that have a Median column
+static std::vector<std::string> get_timing_columns(const results_table& table) {
+  std::vector<std::string> names;
+  for (size_t i = table.num_key_columns; i < table.names.size(); i++) {
+    if (table.find(table.names[i] + "Median") >= 0) names.push_back(table.names[i]);
+  }
+  return names;
+}
+
+// selected: names of the columns to compare, empty for the timing columns
+static std::vector<compared_column> match_columns(const results_table& baseline, const results_table& current,
+    const std::vector<std::string>& selected) {
+  std::vector<compared_column> columns;
+  if (baseline.has_header() && current.has_header()) {
+    for (const auto& name: selected.empty() ? get_timing_columns(baseline) : selected) {
+      const int i = baseline.find(name);
+      const int j = current.find(name);
+      if (i < 0 || j < 0) {
+        if (selected.empty()) continue;
+        throw std::runtime_error("no column " + name + (i < 0 ? " in the baseline" : " in the new results"));
+      }
+      columns.push_back({name, i, j, baseline.find(name + "Stddev"), current.find(name + "Stddev")});
+    }
+    return columns;
+  }
+  // by position, the names come from the table that has them
+  const results_table& named = current.has_header() ? current : baseline;
+  if (!named.has_header() && selected.empty()) {
+    throw std::runtime_error("neither file has a header, choose the timing columns with --columns (for example column3,column4)");
+  }
+  for (const auto& name: selected.empty() ? get_timing_columns(named) : selected) {
+    const int i = named.find(name);
+    if (i < 0) throw std::runtime_error("no column " + name);
+    columns.push_back({name, i, i, -1, -1});
+  }
+  return columns;
+}
+
+static double get_value(const std::vector<double>& row, int index) {
+  if (index < 0 || (size_t) index >= row.size()) return std::numeric_limits<double>::quiet_NaN();
+  return row[index];
+}
+
+results_comparison::results_comparison(double threshold, double alpha, const std::vector<std::string>& columns):
+threshold(threshold), alpha(alpha), columns(columns) {}
+
+// Holm's step-down adjustment of p-values for multiple comparisons, in place
+static void holm_adjust(std::vector<double>& p_values) {
+  const size_t m = p_values.size();
+  std::vector<size_t> order(m);
+  for (size_t i = 0; i < m; i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&p_values](size_t a, size_t b) { return p_values[a] < p_values[b]; });
+  double max_adjusted = 0;
+  for (size_t i = 0; i < m; i++) {
+    max_adjusted = std::max(max_adjusted, std::min(1.0, (m - i) * p_values[order[i]]));
+    p_values[order[i]] = max_adjusted;
+  }
+}
+
+// an aligned row of a compared column
+struct compared_row {
+  std::string key;
+  double baseline_mean;
+  double current_mean;
+  double p_value; // Welch's test of the row, NaN without the repeated-trial data
+};
+
+bool results_comparison::compare(const results_table& baseline, const results_table& current, std::ostream& os) const {
+  const std::vector<compared_column> columns = match_columns(baseline, current, this->columns);
+  if (columns.empty()) throw std::runtime_error("no columns to compare");
+  // the number of samples of the Stddev columns
+  const int baseline_trials_index = baseline.find("Trials");
+  const int current_trials_index = current.find("Trials");
+
+  bool regression = false;
+  os << "Column\tChange\tP\tRows\tResult" << std::endl;
+  for (const auto& column: columns) {
+    std::vector<compared_row> rows;
+    std::vector<double> row_p_values;
+    for (const auto& entry: baseline.rows) {
+      const auto it = current.row_index.find(entry.first);
+      if (it == current.row_index.end()) continue;
+      const std::vector<double>& baseline_row = entry.second;
+      const std::vector<double>& current_row = current.rows[it->second].second;
+      const double baseline_mean = get_value(baseline_row, column.baseline_index);
+      const double current_mean = get_value(current_row, column.current_index);
+      if (!(baseline_mean > 0 && current_mean > 0)) continue;
+
+      const double baseline_stddev = get_value(baseline_row, column.baseline_stddev_index);
+      const double current_stddev = get_value(current_row, column.current_stddev_index);
+      const double baseline_trials = get_value(baseline_row, baseline_trials_index);
+      const double current_trials = get_value(current_row, current_trials_index);
+      double p_value = std::numeric_limits<double>::quiet_NaN();
+      if (!std::isnan(baseline_stddev) && !std::isnan(current_stddev) && baseline_trials >= 2 && current_trials >= 2) {
+        p_value = welch_p_value(baseline_mean, baseline_stddev, baseline_trials, current_mean, current_stddev, current_trials);
+        row_p_values.push_back(p_value);
+      }
+      rows.push_back({entry.first, baseline_mean, current_mean, p_value});
+    }
+    if (rows.empty()) continue;
+
+    double mean = 0;
+    for (const auto& row: rows) mean += std::log(row.current_mean / row.baseline_mean);
+    mean /= rows.size();
+    const double change = std::exp(mean) - 1;
+
+    std::ostringstream significant_rows;
+    bool is_regression = false;
+    bool is_improvement = false;
+    double p_value = std::numeric_limits<double>::quiet_NaN();
+    if (!row_p_values.empty()) {
+      // every row with the repeated-trial data is tested on its own, corrected for the number of rows
+      holm_adjust(row_p_values);
+      size_t i = 0;
+      for (const auto& row: rows) {
+        if (std::isnan(row.p_value)) continue;
+        const double adjusted_p_value = row_p_values[i++];
+        p_value = std::isnan(p_value) ? adjusted_p_value : std::min(p_value, adjusted_p_value);
+        const double row_change = row.current_mean / row.baseline_mean - 1;
+        if (adjusted_p_value < alpha && std::abs(row_change) > threshold) {
+          if (row_change > 0) is_regression = true; else is_improvement = true;
+          significant_rows << "  " << row.key << "\t" << row.baseline_mean << "\t" << row.current_mean << "\t"
+              << (row_change > 0 ? "+" : "") << row_change * 100 << "%\tp=" << adjusted_p_value << std::endl;
+        }
+      }
+    } else if (rows.size() > 1) {
+      // without the repeated-trial data the rows are the samples: paired t-test of the log ratios
+      const size_t n = rows.size();
+      double sum_squares = 0;
+      for (const auto& row: rows) {
+        const double r = std::log(row.current_mean / row.baseline_mean);
+        sum_squares += (r - mean) * (r - mean);
+      }
+      const double stddev = std::sqrt(sum_squares / (n - 1));
+      p_value = stddev > 0 ? student_t_p_value(mean / (stddev / std::sqrt(n)), n - 1) : (mean == 0 ? 1 : 0);
+      if (p_value < alpha && std::abs(change) > threshold) {
+        if (change > 0) is_regression = true; else is_improvement = true;
+      }
+    }
+    if (is_regression) regression = true;
+
+    os << column.name << "\t" << (change > 0 ? "+" : "") << change * 100 << "%\t";
+    if (std::isnan(p_value)) os << "p=n/a"; else os << "p=" << p_value;
+    os << "\t" << rows.size() << "\t"
+        << (std::isnan(p_value) ? "not testable" : is_regression ? "REGRESSION" : is_improvement ? "improvement" : "no significant change")
+        << std::endl;
+    os << significant_rows.str();
+  }
+  return regression;
+}
+
+} /* namespace datasketches */
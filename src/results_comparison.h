@@ -0,0 +1,70 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef RESULTS_COMPARISON_H_
+#define RESULTS_COMPARISON_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+
+namespace datasketches {
+
+/*
+ * Rows of a results TSV keyed by the columns that identify a row: the columns before Trials,
+ * for example Stream and Threads, or only the first column if there is no Trials column.
+ * The header is optional, the stored results in results/ have none.
+ * A file with sections (see sweep_shard) is loaded one section at a time.
+ */
+class results_table {
+public:
+  // the rows of the given section, which must be empty if and only if the file has no sections
+  static results_table load(const std::string& path, const std::string& section = "");
+
+  bool has_header() const { return !names.empty(); }
+  // index of the column with the given name or -1, columnN is the N-th column of a table without a header
+  int find(const std::string& name) const;
+
+  std::vector<std::string> names;
+  size_t num_key_columns;
+  std::vector<std::pair<std::string, std::vector<double>>> rows; // by key (key columns joined with tabs) in file order
+  std::map<std::string, size_t> row_index; // position in rows by key
+};
+
+/*
+ * Compares the timing columns of a new run with a baseline, row by row for the keys present in both.
+ * By default only the timing columns (the ones with a Median column) are compared, which requires a header
+ * in at least one of the tables, or the columns to compare are given by name (lower is better).
+ * If both tables have headers, columns are matched by name, otherwise by position.
+ *
+ * If both tables have the Stddev columns of the timing summary, every row is tested with Welch's t-test
+ * over the trials of that row (the Trials column), with Holm's correction for the number of rows,
+ * and a column is a regression if any row is slower by more than the threshold with a p-value below alpha.
+ * Otherwise, as with the stored results, the rows are the samples of a paired t-test on the log ratios
+ * of the means, and a column is a regression if its geometric mean slowdown exceeds the threshold
+ * with a p-value below alpha. A single row without the repeated-trial data is not testable.
+ */
+class results_comparison {
+public:
+  // columns: names of the columns to compare, empty for the timing columns
+  results_comparison(double threshold, double alpha, const std::vector<std::string>& columns = std::vector<std::string>());
+
+  // prints the changes, returns true if any column is a regression
+  bool compare(const results_table& baseline, const results_table& current, std::ostream& os) const;
+
+private:
+  double threshold;
+  double alpha;
+  std::vector<std::string> columns;
+};
+
+// two-sided p-value of Student's t statistic
+double student_t_p_value(double t, double degrees_of_freedom);
+
+} /* namespace datasketches */
+
+#endif /* RESULTS_COMPARISON_H_ */
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "run_metadata.h"
+#include "characterization_utils.h"
+
+#include <fstream>
+#include <thread>
+#include <ctime>
+#include <cstdio>
+
+#include <unistd.h>
+#include <sys/utsname.h>
+
+namespace datasketches {
+
+static std::string get_cpu_model() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      const size_t colon = line.find(':');
+      if (colon != std::string::npos && colon + 2 <= line.size()) return line.substr(colon + 2);
+    }
+  }
+  return "unknown";
+}
+
+// flags given by the build, or what the predefined macros tell about them
+static std::string get_compiler_flags() {
+#ifdef CHARACTERIZATION_CXXFLAGS
+  return CHARACTERIZATION_CXXFLAGS;
+#else
+  std::string flags;
+#ifdef __OPTIMIZE__
+  flags += " __OPTIMIZE__";
+#endif
+#ifdef __OPTIMIZE_SIZE__
+  flags += " __OPTIMIZE_SIZE__";
+#endif
+#ifdef NDEBUG
+  flags += " NDEBUG";
+#endif
+#ifdef __FAST_MATH__
+  flags += " __FAST_MATH__";
+#endif
+#ifdef __SSE4_2__
+  flags += " __SSE4_2__";
+#endif
+#ifdef __AVX2__
+  flags += " __AVX2__";
+#endif
+#ifdef __AVX512F__
+  flags += " __AVX512F__";
+#endif
+#ifdef __ARM_NEON
+  flags += " __ARM_NEON";
+#endif
+  return flags.empty() ? "unknown" : "predefined:" + flags;
+#endif
+}
+
+static std::string get_compiler() {
+#if defined(__clang__)
+  return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+  return std::string("gcc ") + __VERSION__;
+#else
+  return "unknown";
+#endif
+}
+
+run_metadata run_metadata::collect(int argc, char **argv) {
+  run_metadata metadata;
+  for (int i = 0; i < argc; i++) {
+    if (i > 0) metadata.command_line += " ";
+    metadata.command_line += argv[i];
+  }
+
+  const time_t now = time(nullptr);
+  struct tm utc;
+  gmtime_r(&now, &utc);
+  char time_string[32];
+  strftime(time_string, sizeof(time_string), "%Y-%m-%dT%H:%M:%SZ", &utc);
+  metadata.start_time = time_string;
+
+  char host[256];
+  metadata.host = gethostname(host, sizeof(host)) == 0 ? std::string(host) : "unknown";
+  struct utsname name;
+  metadata.kernel = uname(&name) == 0 ? std::string(name.sysname) + " " + name.release + " " + name.machine : "unknown";
+  metadata.cpu_model = get_cpu_model();
+  metadata.num_cpus = std::thread::hardware_concurrency();
+
+  metadata.compiler = get_compiler();
+  metadata.compiler_flags = get_compiler_flags();
+#ifdef CHARACTERIZATION_LIBRARY_VERSION
+  metadata.library_version = CHARACTERIZATION_LIBRARY_VERSION;
+#else
+  metadata.library_version = "unknown";
+#endif
+  metadata.seed = get_run_seed();
+  metadata.trace = get_trace_path();
+  metadata.shard_index = 0;
+  metadata.num_shards = 1;
+  metadata.cpu = cpu_state::detect();
+  return metadata;
+}
+
+void run_metadata::write_json(std::ostream& os) const {
+  os << "{\"type\": \"metadata\", \"command_line\": ";
+  write_json_string(os, command_line);
+  os << ", \"start_time\": ";
+  write_json_string(os, start_time);
+  os << ", \"host\": ";
+  write_json_string(os, host);
+  os << ", \"kernel\": ";
+  write_json_string(os, kernel);
+  os << ", \"cpu_model\": ";
+  write_json_string(os, cpu_model);
+  os << ", \"num_cpus\": " << num_cpus << ", \"compiler\": ";
+  write_json_string(os, compiler);
+  os << ", \"compiler_flags\": ";
+  write_json_string(os, compiler_flags);
+  os << ", \"library_version\": ";
+  write_json_string(os, library_version);
+  os << ", \"seed\": " << seed << ", \"trace\": ";
+  write_json_string(os, trace);
+  os << ", \"shard_index\": " << shard_index
+      << ", \"num_shards\": " << num_shards << ", \"cpu_state\": ";
+  cpu.write_json(os);
+  os << "}";
+}
+
+void write_json_string(std::ostream& os, const std::string& s) {
+  os << '"';
+  for (unsigned char c: s) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      os << escaped;
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+} /* namespace datasketches */
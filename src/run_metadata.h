@@ -0,0 +1,50 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef RUN_METADATA_H_
+#define RUN_METADATA_H_
+
+#include <cstdint>
+#include <string>
+#include <iostream>
+
+#include "cpu_isolation.h"
+
+namespace datasketches {
+
+/*
+ * The environment that produced a result, written as the first line of the JSON output.
+ * The build can record what the compiler cannot report by defining
+ * CHARACTERIZATION_CXXFLAGS (the compiler flags) and CHARACTERIZATION_LIBRARY_VERSION
+ * (the version or commit of sketches-core-cpp) as string literals.
+ */
+struct run_metadata {
+  std::string command_line;
+  std::string start_time; // UTC, ISO 8601
+  std::string host;
+  std::string kernel;
+  std::string cpu_model;
+  unsigned num_cpus;
+  std::string compiler;
+  std::string compiler_flags;
+  std::string library_version;
+  uint64_t seed;
+  std::string trace; // replayed instead of the generated input, empty if none
+  unsigned shard_index;
+  unsigned num_shards;
+  cpu_state cpu; // pinning, frequency scaling, SMT and the governor
+
+  static run_metadata collect(int argc, char **argv);
+
+  // one line JSON object with "type": "metadata"
+  void write_json(std::ostream& os) const;
+};
+
+// writes the string as a quoted JSON string
+void write_json_string(std::ostream& os, const std::string& s);
+
+} /* namespace datasketches */
+
+#endif /* RUN_METADATA_H_ */
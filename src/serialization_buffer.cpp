@@ -0,0 +1,47 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "serialization_buffer.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace datasketches {
+
+mapped_buffer::mapped_buffer(size_t capacity): ptr(nullptr), capacity_bytes(capacity) {
+  const char* tmp_dir = getenv("TMPDIR");
+  std::string path_template = std::string(tmp_dir != nullptr ? tmp_dir : "/tmp") + "/characterization-XXXXXX";
+  std::vector<char> path(path_template.begin(), path_template.end());
+  path.push_back(0);
+  const int fd = mkstemp(path.data());
+  if (fd == -1) throw std::runtime_error("cannot create " + path_template + ": " + strerror(errno));
+  unlink(path.data());
+  if (ftruncate(fd, capacity) == -1) {
+    close(fd);
+    throw std::runtime_error(std::string("cannot resize mapped buffer: ") + strerror(errno));
+  }
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  flags |= MAP_POPULATE;
+#endif
+  void* p = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, flags, fd, 0);
+  close(fd); // the mapping stays valid
+  if (p == MAP_FAILED) throw std::runtime_error(std::string("cannot map buffer: ") + strerror(errno));
+  ptr = static_cast<char*>(p);
+  memset(ptr, 0, capacity); // allocates the pages of the file and marks them dirty
+}
+
+mapped_buffer::~mapped_buffer() {
+  munmap(ptr, capacity_bytes);
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef SERIALIZATION_BUFFER_H_
+#define SERIALIZATION_BUFFER_H_
+
+#include <cstddef>
+#include <streambuf>
+
+namespace datasketches {
+
+/*
+ * Stream buffer over a fixed region of memory supplied by the caller, so that a sketch can be serialized
+ * through the std::ostream API without any allocation or copying into a growing buffer.
+ * Writing past the end fails the stream (badbit).
+ */
+class fixed_streambuf: public std::streambuf {
+public:
+  fixed_streambuf(char* data, size_t capacity) {
+    setp(data, data + capacity);
+    setg(data, data, data + capacity);
+  }
+
+  // number of bytes written
+  size_t size() const { return pptr() - pbase(); }
+};
+
+/*
+ * Writable shared mapping of a temporary file, to hold serialized sketches back to back.
+ * The file is created in TMPDIR (default /tmp) and unlinked immediately, so it goes away with the process.
+ * All pages are allocated and faulted in on construction, so that writes in timed regions do not include page faults.
+ */
+class mapped_buffer {
+public:
+  explicit mapped_buffer(size_t capacity);
+  mapped_buffer(const mapped_buffer&) = delete;
+  mapped_buffer& operator=(const mapped_buffer&) = delete;
+  ~mapped_buffer();
+
+  char* data() { return ptr; }
+  size_t capacity() const { return capacity_bytes; }
+
+private:
+  char* ptr;
+  size_t capacity_bytes;
+};
+
+} /* namespace datasketches */
+
+#endif /* SERIALIZATION_BUFFER_H_ */
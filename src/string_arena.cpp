@@ -0,0 +1,64 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "string_arena.h"
+
+namespace datasketches {
+
+static thread_local string_arena* current_arena = nullptr;
+
+string_arena::string_arena(): chunk_index(0), offset(0) {
+  for (auto& list: free_lists) list = nullptr;
+}
+
+string_arena::~string_arena() {
+  if (current_arena == this) current_arena = nullptr;
+  for (char* chunk: chunks) ::operator delete(chunk);
+}
+
+void* string_arena::allocate(size_t bytes) {
+  if (bytes > MAX_SMALL_SIZE) return ::operator new(bytes);
+  const size_t size_class = bytes == 0 ? 0 : (bytes - 1) / GRANULE;
+  void* block = free_lists[size_class];
+  if (block != nullptr) {
+    free_lists[size_class] = *static_cast<void**>(block);
+    return block;
+  }
+  const size_t block_size = (size_class + 1) * GRANULE;
+  if (chunks.empty() || offset + block_size > CHUNK_SIZE) {
+    if (!chunks.empty()) chunk_index++;
+    if (chunk_index == chunks.size()) chunks.push_back(static_cast<char*>(::operator new(CHUNK_SIZE)));
+    offset = 0;
+  }
+  block = chunks[chunk_index] + offset;
+  offset += block_size;
+  return block;
+}
+
+void string_arena::deallocate(void* p, size_t bytes) {
+  if (bytes > MAX_SMALL_SIZE) {
+    ::operator delete(p);
+    return;
+  }
+  const size_t size_class = bytes == 0 ? 0 : (bytes - 1) / GRANULE;
+  *static_cast<void**>(p) = free_lists[size_class];
+  free_lists[size_class] = p;
+}
+
+void string_arena::clear() {
+  for (auto& list: free_lists) list = nullptr;
+  chunk_index = 0;
+  offset = 0;
+}
+
+string_arena* string_arena::get_current() {
+  return current_arena;
+}
+
+void string_arena::set_current(string_arena* arena) {
+  current_arena = arena;
+}
+
+} /* namespace datasketches */
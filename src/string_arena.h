@@ -0,0 +1,93 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef STRING_ARENA_H_
+#define STRING_ARENA_H_
+
+#include <cstddef>
+#include <vector>
+#include <new>
+
+namespace datasketches {
+
+/*
+ * Memory for the keys of one sketch: small blocks are carved from large chunks and recycled through
+ * free lists by size class, so copying and freeing a key never goes to the general purpose heap.
+ * clear() releases everything at once and keeps the chunks for the next sketch.
+ * Blocks above the largest size class, such as the arrays of the hash map, use the heap.
+ */
+class string_arena {
+public:
+  string_arena();
+  ~string_arena();
+  string_arena(const string_arena&) = delete;
+  string_arena& operator=(const string_arena&) = delete;
+
+  void* allocate(size_t bytes);
+  void deallocate(void* p, size_t bytes);
+
+  // all small blocks become free, must not be called while they are in use
+  void clear();
+
+  // arena of arena_allocator on the calling thread, nullptr means the heap
+  static string_arena* get_current();
+  static void set_current(string_arena* arena);
+
+private:
+  static const size_t CHUNK_SIZE = 1 << 20;
+  static const size_t GRANULE = 16;
+  static const size_t MAX_SMALL_SIZE = 1024;
+  static const size_t NUM_SIZE_CLASSES = MAX_SMALL_SIZE / GRANULE;
+
+  std::vector<char*> chunks;
+  size_t chunk_index;
+  size_t offset;
+  void* free_lists[NUM_SIZE_CLASSES];
+};
+
+/*
+ * Standard allocator that takes memory from the current string_arena of the calling thread.
+ * Allocators cannot be passed to the sketches, so the arena is selected per thread:
+ * a profile makes the arena of a sketch current before working on that sketch.
+ */
+template<typename T>
+class arena_allocator {
+public:
+  typedef T value_type;
+
+  arena_allocator() noexcept {}
+  template<typename U>
+  arena_allocator(const arena_allocator<U>&) noexcept {}
+
+  template<typename U>
+  struct rebind {
+    typedef arena_allocator<U> other;
+  };
+
+  T* allocate(size_t n) {
+    string_arena* arena = string_arena::get_current();
+    if (arena == nullptr) return static_cast<T*>(::operator new(n * sizeof(T)));
+    return static_cast<T*>(arena->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    string_arena* arena = string_arena::get_current();
+    if (arena == nullptr) {
+      ::operator delete(p);
+    } else {
+      arena->deallocate(p, n * sizeof(T));
+    }
+  }
+};
+
+template<typename T, typename U>
+bool operator==(const arena_allocator<T>&, const arena_allocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const arena_allocator<T>&, const arena_allocator<U>&) { return false; }
+
+} /* namespace datasketches */
+
+#endif /* STRING_ARENA_H_ */
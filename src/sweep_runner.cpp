@@ -0,0 +1,133 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "sweep_runner.h"
+#include "cpu_isolation.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+namespace datasketches {
+
+sweep_runner::sweep_runner(unsigned num_shards, const std::string& directory):
+num_shards(num_shards),
+directory(directory),
+is_json_enabled(false),
+metadata()
+{
+  if (num_shards == 0) throw std::invalid_argument("number of shards must be positive");
+}
+
+bool sweep_runner::run(const std::function<void(sweep_shard&)>& run_shard) const {
+  std::cout << std::flush;
+  std::cerr << std::flush;
+  std::vector<pid_t> children;
+  for (unsigned i = 0; i < num_shards; i++) {
+    const pid_t pid = fork();
+    if (pid == -1) throw std::runtime_error(std::string("cannot start shard process: ") + strerror(errno));
+    if (pid == 0) {
+      int status = 0;
+      try {
+        select_shard_cpus(i, num_shards);
+        this->run_shard(i, run_shard);
+      } catch (std::exception& e) {
+        std::cerr << "shard " << i << ": " << e.what() << std::endl;
+        status = 1;
+      }
+      _exit(status);
+    }
+    children.push_back(pid);
+  }
+
+  bool success = true;
+  for (unsigned i = 0; i < num_shards; i++) {
+    int status;
+    if (waitpid(children[i], &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "shard " << i << " did not complete, run again to resume" << std::endl;
+      success = false;
+    }
+  }
+  return success;
+}
+
+void sweep_runner::run_shard(unsigned shard_index, const std::function<void(sweep_shard&)>& run_shard) const {
+  if (mkdir(directory.c_str(), 0755) == -1 && errno != EEXIST) {
+    throw std::runtime_error("cannot create directory " + directory + ": " + strerror(errno));
+  }
+  pin_thread(0);
+  bind_memory_to_pinned_cpus();
+  sweep_shard shard(shard_index, num_shards, get_path(shard_index));
+  if (is_json_enabled) {
+    // the state of the CPUs of this shard
+    run_metadata shard_metadata(metadata);
+    shard_metadata.cpu = cpu_state::detect();
+    shard.enable_json(get_json_path(shard_index), shard_metadata);
+  }
+  run_shard(shard);
+}
+
+void sweep_runner::merge(std::ostream& os) const {
+  // sections in the order they first appear, the unnamed section of a profile without sections first
+  std::vector<std::string> sections = {""};
+  std::map<std::string, std::string> headers;
+  std::map<std::string, std::multimap<size_t, std::string>> rows;
+  for (unsigned i = 0; i < num_shards; i++) {
+    std::ifstream file(get_path(i));
+    std::string line;
+    std::string section;
+    while (std::getline(file, line)) {
+      if (file.eof()) break; // incomplete row
+      if (!line.empty() && isdigit(line[0])) {
+        rows[section].emplace(std::stoull(line), line);
+      } else if (line.compare(0, 2, "# ") == 0) {
+        section = line.substr(2);
+        if (std::find(sections.begin(), sections.end(), section) == sections.end()) sections.push_back(section);
+      } else if (headers[section].empty()) {
+        headers[section] = line;
+      }
+    }
+  }
+  for (const auto& section: sections) {
+    if (!section.empty()) os << "# " << section << std::endl;
+    if (!headers[section].empty()) os << headers[section] << std::endl;
+    for (auto& it: rows[section]) os << it.second << std::endl;
+  }
+}
+
+void sweep_runner::enable_json(const run_metadata& metadata) {
+  is_json_enabled = true;
+  this->metadata = metadata;
+}
+
+void sweep_runner::merge_json(std::ostream& os) const {
+  for (unsigned i = 0; i < num_shards; i++) {
+    std::ifstream file(get_json_path(i));
+    std::string line;
+    while (std::getline(file, line)) {
+      if (file.eof()) break; // incomplete record
+      os << line << std::endl;
+    }
+  }
+}
+
+std::string sweep_runner::get_path(unsigned shard_index) const {
+  return directory + "/shard-" + std::to_string(shard_index) + ".tsv";
+}
+
+std::string sweep_runner::get_json_path(unsigned shard_index) const {
+  return directory + "/shard-" + std::to_string(shard_index) + ".jsonl";
+}
+
+} /* namespace datasketches */
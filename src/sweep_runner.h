@@ -0,0 +1,55 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef SWEEP_RUNNER_H_
+#define SWEEP_RUNNER_H_
+
+#include <string>
+#include <functional>
+#include <iostream>
+
+#include "sweep_shard.h"
+#include "run_metadata.h"
+
+namespace datasketches {
+
+/*
+ * Runs the shards of a sweep as independent local processes, each writing its rows to
+ * its own file in the given directory, and merges these files into one table ordered by stream length.
+ * Running again in the same directory continues where the previous attempt stopped.
+ * Shard files from other machines (shard-<index>.tsv) can be copied into the directory and merged.
+ */
+class sweep_runner {
+public:
+  sweep_runner(unsigned num_shards, const std::string& directory);
+
+  // runs all shards in parallel processes, returns true if all of them completed
+  bool run(const std::function<void(sweep_shard&)>& run_shard) const;
+
+  // runs one shard in the current process
+  void run_shard(unsigned shard_index, const std::function<void(sweep_shard&)>& run_shard) const;
+
+  // writes the header and the rows of all shards ordered by stream length
+  void merge(std::ostream& os) const;
+
+  // shards also write JSON records (shard-<index>.jsonl) starting with the given metadata
+  void enable_json(const run_metadata& metadata);
+
+  // writes the JSON records of all shards, each after the metadata of the process that produced it
+  void merge_json(std::ostream& os) const;
+
+private:
+  unsigned num_shards;
+  std::string directory;
+  bool is_json_enabled;
+  run_metadata metadata;
+
+  std::string get_path(unsigned shard_index) const;
+  std::string get_json_path(unsigned shard_index) const;
+};
+
+} /* namespace datasketches */
+
+#endif /* SWEEP_RUNNER_H_ */
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "sweep_shard.h"
+
+#include <stdexcept>
+#include <functional>
+#include <sstream>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include <unistd.h>
+
+namespace datasketches {
+
+/*
+ * Passes characters through to the destination (if any) and calls on_line() with every complete line,
+ * before the newline reaches the destination.
+ */
+class line_tee: public std::streambuf {
+public:
+  line_tee(std::streambuf* destination, std::function<void(const std::string&)> on_line):
+    destination(destination), on_line(on_line) {}
+
+protected:
+  virtual int overflow(int c) {
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    if (c == '\n') {
+      on_line(line);
+      line.clear();
+    } else {
+      line.push_back(c);
+    }
+    if (destination != nullptr && destination->sputc(c) == traits_type::eof()) return traits_type::eof();
+    return c;
+  }
+
+  virtual int sync() {
+    return destination != nullptr ? destination->pubsync() : 0;
+  }
+
+private:
+  std::streambuf* destination;
+  std::function<void(const std::string&)> on_line;
+  std::string line;
+};
+
+static std::vector<std::string> split_tabs(const std::string& line) {
+  std::vector<std::string> fields;
+  std::istringstream is(line);
+  std::string field;
+  while (std::getline(is, field, '\t')) fields.push_back(field);
+  return fields;
+}
+
+// writes the field as a JSON number if it is one, otherwise as a string
+static void write_json_value(std::ostream& os, const std::string& field) {
+  const char* begin = field.c_str();
+  char* end;
+  const double value = strtod(begin, &end);
+  if (end != begin && *end == 0) {
+    if (std::isfinite(value)) os << field;
+    else os << "null";
+  } else {
+    write_json_string(os, field);
+  }
+}
+
+// drops an incomplete last line left by an interrupted run
+static void truncate_incomplete_line(const std::string& path) {
+  std::ifstream previous(path);
+  if (!previous) return;
+  size_t valid_length = 0;
+  std::string line;
+  while (std::getline(previous, line)) {
+    if (previous.eof()) break;
+    valid_length += line.size() + 1;
+  }
+  previous.close();
+  if (truncate(path.c_str(), valid_length) == -1) throw std::runtime_error("cannot truncate " + path);
+}
+
+sweep_shard::sweep_shard():
+shard_index(0),
+num_shards(1),
+point_index(0),
+discard(nullptr)
+{}
+
+sweep_shard::sweep_shard(unsigned shard_index, unsigned num_shards, const std::string& path):
+shard_index(shard_index),
+num_shards(num_shards),
+point_index(0),
+discard(nullptr)
+{
+  if (num_shards == 0 || shard_index >= num_shards) throw std::invalid_argument("invalid shard index");
+
+  // keep complete lines of a previous attempt, a line without a newline at the end was interrupted
+  size_t valid_length = 0;
+  {
+    std::ifstream previous(path);
+    std::string line;
+    std::string previous_section;
+    while (std::getline(previous, line)) {
+      if (previous.eof()) break;
+      if (!line.empty() && isdigit(line[0])) {
+        done_points.insert(std::make_pair(previous_section, (size_t) std::stoull(line)));
+      } else if (line.compare(0, 2, "# ") == 0) {
+        previous_section = line.substr(2);
+      } else {
+        sections_with_header.insert(previous_section);
+      }
+      valid_length += line.size() + 1;
+    }
+  }
+  if (access(path.c_str(), F_OK) == 0 && truncate(path.c_str(), valid_length) == -1) throw std::runtime_error("cannot truncate " + path);
+  file.open(path, std::ios::out | std::ios::app);
+  if (!file) throw std::runtime_error("cannot open " + path);
+}
+
+bool sweep_shard::should_run(size_t stream_length) {
+  const bool is_assigned = point_index++ % num_shards == shard_index;
+  return is_assigned && done_points.find(std::make_pair(section, stream_length)) == done_points.end();
+}
+
+void sweep_shard::begin_section(const std::string& name) {
+  section = name;
+  // not through out(), the line is not a row
+  get_out_destination() << "# " << name << std::endl;
+  if (json.is_open()) {
+    json << "{\"type\": \"section\", \"name\": ";
+    write_json_string(json, name);
+    json << "}" << std::endl;
+    reset_header_stream();
+  }
+}
+
+std::ostream& sweep_shard::header() {
+  return header_stream ? *header_stream : get_header_destination();
+}
+
+std::ostream& sweep_shard::out() {
+  return out_stream ? *out_stream : get_out_destination();
+}
+
+std::ostream& sweep_shard::get_header_destination() {
+  if (!file.is_open()) return std::cout;
+  return sections_with_header.count(section) > 0 ? discard : file;
+}
+
+std::ostream& sweep_shard::get_out_destination() {
+  if (!file.is_open()) return std::cout;
+  return file;
+}
+
+void sweep_shard::enable_json(const std::string& path, run_metadata metadata) {
+  truncate_incomplete_line(path);
+  json.open(path, std::ios::out | std::ios::app);
+  if (!json) throw std::runtime_error("cannot open " + path);
+  metadata.shard_index = shard_index;
+  metadata.num_shards = num_shards;
+  metadata.write_json(json);
+  json << std::endl;
+
+  reset_header_stream();
+  out_tee.reset(new line_tee(get_out_destination().rdbuf(), [this](const std::string& line) { write_json_record(line); }));
+  out_stream.reset(new std::ostream(out_tee.get()));
+}
+
+// the destination of the header depends on the section
+void sweep_shard::reset_header_stream() {
+  header_tee.reset(new line_tee(get_header_destination().rdbuf(), [this](const std::string& line) { names = split_tabs(line); }));
+  header_stream.reset(new std::ostream(header_tee.get()));
+}
+
+void sweep_shard::add_row_samples(raw_samples samples) {
+  if (json.is_open()) pending_samples.push_back(std::move(samples));
+}
+
+void sweep_shard::write_json_record(const std::string& row) {
+  const std::vector<std::string> fields = split_tabs(row);
+  if (fields.empty()) return;
+  json << "{\"type\": \"point\", ";
+  if (!section.empty()) {
+    json << "\"section\": ";
+    write_json_string(json, section);
+    json << ", ";
+  }
+  json << "\"stream_length\": " << fields[0] << ", \"values\": {";
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (i > 0) json << ", ";
+    write_json_string(json, i < names.size() ? names[i] : "column" + std::to_string(i + 1));
+    json << ": ";
+    write_json_value(json, fields[i]);
+  }
+  json << "}, \"samples\": {";
+  if (!pending_samples.empty()) {
+    const raw_samples& samples = pending_samples.front();
+    for (size_t i = 0; i < samples.size(); i++) {
+      if (i > 0) json << ", ";
+      write_json_string(json, samples[i].first);
+      json << ": [";
+      for (size_t j = 0; j < samples[i].second.size(); j++) {
+        if (j > 0) json << ", ";
+        const double value = samples[i].second[j];
+        if (std::isfinite(value)) json << value;
+        else json << "null";
+      }
+      json << "]";
+    }
+    pending_samples.pop_front();
+  }
+  json << "}}" << std::endl;
+}
+
+// defined here, where line_tee is complete
+sweep_shard::~sweep_shard() {}
+
+} /* namespace datasketches */
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef SWEEP_SHARD_H_
+#define SWEEP_SHARD_H_
+
+#include <cstddef>
+#include <string>
+#include <set>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <memory>
+
+#include "run_metadata.h"
+
+namespace datasketches {
+
+// samples of each trial by column name
+typedef std::vector<std::pair<std::string, std::vector<double>>> raw_samples;
+
+class line_tee;
+
+/*
+ * The part of a sweep over stream lengths computed by one process, and the destination of its rows.
+ * Points are assigned to shards round-robin by their position in the sweep, so that the expensive
+ * points at the end of the sweep are spread across shards.
+ * A shard writing to a file is resumable: every row is flushed as soon as it is complete,
+ * and points that already have a row in the file are skipped when the shard is restarted.
+ * The first column of a row must be the stream length.
+ *
+ * Optionally the shard also writes a JSON lines file: the metadata of the run, then one record per row
+ * with the values by column name and the raw samples that the profile added for the row.
+ * A record is written before the end of its row, so on restart a point may get a second record, never none.
+ *
+ * A profile that runs several sweeps, for example one per sketch type, starts each with begin_section().
+ * A section is a "# name" line followed by its own header and rows. Points are numbered across sections
+ * for the assignment to shards, and finished points are tracked per section.
+ */
+class sweep_shard {
+public:
+  // the whole sweep, rows go to std::cout
+  sweep_shard();
+
+  // rows are appended to the file at the given path
+  sweep_shard(unsigned shard_index, unsigned num_shards, const std::string& path);
+
+  // must be called once for every point of the sweep in order
+  // returns true if this shard needs to compute the point
+  bool should_run(size_t stream_length);
+
+  // starts a sweep of its own, before its header and its first should_run()
+  void begin_section(const std::string& name);
+
+  // stream for the column names, discards them if the file already has them
+  std::ostream& header();
+
+  // stream for the rows, each row must end with std::endl
+  std::ostream& out();
+
+  // appends JSON records to the file at the given path, starting with the metadata
+  void enable_json(const std::string& path, run_metadata metadata);
+
+  // raw samples for the JSON record of the next row written to out() that has none yet,
+  // a profile that buffers several rows adds their samples in the same order
+  void add_row_samples(raw_samples samples);
+
+  ~sweep_shard();
+
+private:
+  unsigned shard_index;
+  unsigned num_shards;
+  size_t point_index;
+  std::string section;
+  std::set<std::pair<std::string, size_t>> done_points;
+  std::set<std::string> sections_with_header;
+  std::ofstream file;
+  std::ostream discard;
+
+  std::ofstream json;
+  std::vector<std::string> names;
+  std::deque<raw_samples> pending_samples;
+  std::unique_ptr<line_tee> header_tee;
+  std::unique_ptr<line_tee> out_tee;
+  std::unique_ptr<std::ostream> header_stream;
+  std::unique_ptr<std::ostream> out_stream;
+
+  std::ostream& get_header_destination();
+  std::ostream& get_out_destination();
+  void reset_header_stream();
+  void write_json_record(const std::string& row);
+};
+
+} /* namespace datasketches */
+
+#endif /* SWEEP_SHARD_H_ */
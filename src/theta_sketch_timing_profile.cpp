@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "theta_sketch_timing_profile.h"
+#include "timing_profile.h"
+#include "distinct_count_timing.h"
+#include "counting_allocator.h"
+
+#include <theta_sketch.hpp>
+#include <theta_union.hpp>
+#include <theta_intersection.hpp>
+
+namespace datasketches {
+
+typedef update_theta_sketch_alloc<counting_allocator<void>> counted_update_theta_sketch;
+typedef compact_theta_sketch_alloc<counting_allocator<void>> counted_compact_theta_sketch;
+typedef theta_union_alloc<counting_allocator<void>> counted_theta_union;
+typedef theta_intersection_alloc<counting_allocator<void>> counted_theta_intersection;
+
+static const uint8_t lg_k(12);
+
+/*
+ * Union and intersection of the trial sketch with a second sketch of the same stream length
+ * that shares half of its values. Union and Inter include building the union or intersection
+ * object and getting the result.
+ */
+class theta_set_operations_timing {
+public:
+  // some arbitrary starting value, different from the one of the input
+  theta_set_operations_timing(): union_column("Union"), intersection_column("Inter"), counter(7177486359) {}
+  void header(std::ostream& os) const { os << "\t" << union_column.get_name() << "\t" << intersection_column.get_name(); }
+  void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&union_column); columns.push_back(&intersection_column); }
+  void clear() { union_column.clear(); intersection_column.clear(); }
+
+  void run(const counted_update_theta_sketch& sketch, const uint64_t* items, size_t stream_length) {
+    const uint64_t golden64(0x9e3779b97f4a7c13ULL);
+    auto other = counted_update_theta_sketch::builder().set_lg_k(lg_k).build();
+    for (size_t j = stream_length / 2; j < stream_length; j++) other.update(items[j]);
+    for (size_t j = stream_length / 2; j < stream_length; j++) {
+      other.update(counter);
+      counter += golden64;
+    }
+    const counted_compact_theta_sketch compact_sketch(sketch.compact());
+    const counted_compact_theta_sketch compact_other(other.compact());
+
+    const auto start_union(union_column.start());
+    counted_theta_union u = counted_theta_union::builder().set_lg_k(lg_k).build();
+    u.update(compact_sketch);
+    u.update(compact_other);
+    do_not_optimize(u.get_result());
+    union_column.stop(start_union);
+
+    const auto start_intersection(intersection_column.start());
+    counted_theta_intersection intersection;
+    intersection.update(compact_sketch);
+    intersection.update(compact_other);
+    do_not_optimize(intersection.get_result());
+    intersection_column.stop(start_intersection);
+  }
+
+  void print(std::ostream& os, size_t) const { os << "\t" << union_column.get_mean() << "\t" << intersection_column.get_mean(); }
+
+private:
+  timing_column union_column;
+  timing_column intersection_column;
+  uint64_t counter;
+};
+
+struct theta_timing_traits: public distinct_count_timing_traits {
+  typedef counted_update_theta_sketch sketch_type;
+
+  counted_update_theta_sketch build() { return counted_update_theta_sketch::builder().set_lg_k(lg_k).build(); }
+
+  auto make_operations() {
+    return std::make_tuple(
+      make_stream_serde_timing("Ser", "Deser",
+          [](const counted_update_theta_sketch& sketch, std::ostream& os) { sketch.serialize(os); },
+          [](std::istream& is) { return counted_update_theta_sketch::deserialize(is); }),
+      make_statistic("Size", get_serialized_size_bytes<counted_update_theta_sketch>),
+      theta_set_operations_timing()
+    );
+  }
+};
+
+void theta_sketch_timing_profile::run(sweep_shard& shard) {
+  timing_profile<theta_timing_traits>().run(shard);
+}
+
+} /* namespace datasketches */
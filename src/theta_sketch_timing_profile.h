@@ -0,0 +1,20 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef THETA_SKETCH_TIMING_PROFILE_H_
+#define THETA_SKETCH_TIMING_PROFILE_H_
+
+#include "profile.h"
+
+namespace datasketches {
+
+class theta_sketch_timing_profile: public profile {
+public:
+  virtual void run(sweep_shard& shard);
+};
+
+} /* namespace datasketches */
+
+#endif /* THETA_SKETCH_TIMING_PROFILE_H_ */
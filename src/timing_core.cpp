@@ -0,0 +1,214 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "timing_core.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace datasketches {
+
+timer::calibration::calibration() {
+  const size_t num_samples(10000);
+  std::vector<double> deltas(num_samples);
+  for (size_t i = 0; i < num_samples; i++) {
+    const auto start = clock::now();
+    const auto finish = clock::now();
+    deltas[i] = std::chrono::duration<double, std::nano>(finish - start).count();
+  }
+  resolution_ns = std::numeric_limits<double>::max();
+  for (double delta: deltas) if (delta > 0) resolution_ns = std::min(resolution_ns, delta);
+  if (resolution_ns == std::numeric_limits<double>::max()) {
+    // the clock did not advance at all, fall back to its declared period
+    resolution_ns = std::chrono::duration<double, std::nano>(clock::duration(1)).count();
+  }
+  std::nth_element(deltas.begin(), deltas.begin() + num_samples / 2, deltas.end());
+  overhead_ns = deltas[num_samples / 2];
+}
+
+const timer::calibration& timer::get_calibration() {
+  static const calibration c;
+  return c;
+}
+
+double timer::elapsed_ns(time_point start) {
+  const double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count() - get_overhead_ns();
+  return elapsed > 0 ? elapsed : 0;
+}
+
+double timer::get_overhead_ns() {
+  return get_calibration().overhead_ns;
+}
+
+double timer::get_resolution_ns() {
+  return get_calibration().resolution_ns;
+}
+
+double timer::get_min_sample_ns() {
+  return std::max(1000.0, std::max(1000 * get_resolution_ns(), 100 * get_overhead_ns()));
+}
+
+timing_column::timing_column(const std::string& name): name(name) {
+  clear();
+}
+
+const std::string& timing_column::get_name() const {
+  return name;
+}
+
+void timing_column::stop(const region_start& start, size_t num_ops) {
+  add_sample(timer::elapsed_ns(start.time) / num_ops);
+  add_counters(start.counters, perf_counters::read(), num_ops);
+  add_allocations(start.allocations, num_ops);
+}
+
+void timing_column::add_allocations(const allocation_stats& start, size_t num_ops) {
+  const allocation_stats& finish = allocation_stats::get();
+  allocation_sums[ALLOCATIONS] += (double) (finish.num_allocations - start.num_allocations) / num_ops;
+  allocation_sums[ALLOCATED_BYTES] += (double) (finish.bytes_allocated - start.bytes_allocated) / num_ops;
+  allocation_sums[PEAK_BYTES] += finish.peak_live_bytes - start.live_bytes;
+  num_allocation_samples++;
+}
+
+void timing_column::add_counters(const perf_counters::values& start, const perf_counters::values& finish, size_t num_ops) {
+  if (!perf_counters::is_enabled()) return;
+  double counts[perf_counters::NUM_COUNTERS];
+  if (!perf_counters::get_region_counts(start, finish, counts)) return;
+  for (unsigned i = 0; i < perf_counters::NUM_COUNTERS; i++) counter_sums[i] += counts[i] / num_ops;
+  num_counter_samples++;
+}
+
+void timing_column::add_sample(double ns_per_op) {
+  samples.push_back(ns_per_op);
+}
+
+void timing_column::clear() {
+  samples.clear();
+  for (unsigned i = 0; i < perf_counters::NUM_COUNTERS; i++) counter_sums[i] = 0;
+  num_counter_samples = 0;
+  for (unsigned i = 0; i < NUM_ALLOCATION_METRICS; i++) allocation_sums[i] = 0;
+  num_allocation_samples = 0;
+}
+
+double timing_column::get_mean() const {
+  if (samples.empty()) return 0;
+  double sum = 0;
+  for (double sample: samples) sum += sample;
+  return sum / samples.size();
+}
+
+double timing_column::get_counter_mean(unsigned counter) const {
+  if (num_counter_samples == 0) return 0;
+  return counter_sums[counter] / num_counter_samples;
+}
+
+double timing_column::get_allocation_mean(unsigned metric) const {
+  if (num_allocation_samples == 0) return 0;
+  return allocation_sums[metric] / num_allocation_samples;
+}
+
+const char* timing_column::get_allocation_metric_name(unsigned metric) {
+  static const char* names[NUM_ALLOCATION_METRICS] = {"Allocs", "AllocBytes", "PeakBytes"};
+  return names[metric];
+}
+
+// two-sided 95% quantile of Student's t distribution
+static double t_quantile_95(size_t degrees_of_freedom) {
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  // beyond 30 the quantile is close to linear in 1 / df, interpolated between these points (1 / inf = 0)
+  static const double large_df[] = {30, 40, 60, 120};
+  static const double large_df_table[] = {2.042, 2.021, 2.000, 1.980, 1.960};
+  if (degrees_of_freedom == 0) return std::numeric_limits<double>::infinity();
+  if (degrees_of_freedom <= 30) return table[degrees_of_freedom - 1];
+  const double x = 1.0 / degrees_of_freedom;
+  for (unsigned i = 1; i <= 4; i++) {
+    const double x_high = 1 / large_df[i - 1];
+    const double x_low = i < 4 ? 1 / large_df[i] : 0;
+    if (x >= x_low) {
+      return large_df_table[i] + (large_df_table[i - 1] - large_df_table[i]) * (x - x_low) / (x_high - x_low);
+    }
+  }
+  return large_df_table[4];
+}
+
+timing_summary timing_column::get_summary() const {
+  timing_summary summary;
+  summary.num_samples = samples.size();
+  summary.mean = get_mean();
+  if (samples.empty()) {
+    summary.median = summary.stddev = summary.ci_low = summary.ci_high = 0;
+    return summary;
+  }
+
+  std::vector<double> sorted(samples);
+  std::sort(sorted.begin(), sorted.end());
+  const size_t n = sorted.size();
+  summary.median = (n % 2 == 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+  double sum_squares = 0;
+  for (double sample: samples) sum_squares += (sample - summary.mean) * (sample - summary.mean);
+  summary.stddev = n > 1 ? std::sqrt(sum_squares / (n - 1)) : 0;
+
+  const double half_width = n > 1 ? t_quantile_95(n - 1) * summary.stddev / std::sqrt(n) : 0;
+  summary.ci_low = summary.mean - half_width;
+  summary.ci_high = summary.mean + half_width;
+  return summary;
+}
+
+raw_samples get_raw_samples(const std::vector<timing_column*>& columns) {
+  raw_samples samples;
+  for (auto column: columns) samples.push_back(std::make_pair(column->get_name(), column->get_samples()));
+  return samples;
+}
+
+void print_timing_summary_header(std::ostream& os, const std::vector<timing_column*>& columns) {
+  print_timing_summary_header(os, columns, columns);
+}
+
+void print_timing_summary_header(std::ostream& os, const std::vector<timing_column*>& columns,
+    const std::vector<timing_column*>& stats_columns) {
+  for (auto column: columns) {
+    const std::string& name = column->get_name();
+    os << "\t" << name << "Median\t" << name << "Stddev\t" << name << "CILow\t" << name << "CIHigh";
+  }
+  for (auto column: stats_columns) {
+    for (unsigned i = 0; i < timing_column::NUM_ALLOCATION_METRICS; i++) {
+      os << "\t" << column->get_name() << timing_column::get_allocation_metric_name(i);
+    }
+  }
+  if (!perf_counters::is_enabled()) return;
+  for (auto column: stats_columns) {
+    for (unsigned i = 0; i < perf_counters::NUM_COUNTERS; i++) os << "\t" << column->get_name() << perf_counters::get_name(i);
+  }
+}
+
+void print_timing_summary(std::ostream& os, const std::vector<timing_column*>& columns) {
+  print_timing_summary(os, columns, columns);
+}
+
+void print_timing_summary(std::ostream& os, const std::vector<timing_column*>& columns,
+    const std::vector<timing_column*>& stats_columns) {
+  for (auto column: columns) {
+    const timing_summary summary = column->get_summary();
+    os << "\t" << summary.median << "\t" << summary.stddev << "\t" << summary.ci_low << "\t" << summary.ci_high;
+  }
+  for (auto column: stats_columns) {
+    for (unsigned i = 0; i < timing_column::NUM_ALLOCATION_METRICS; i++) os << "\t" << column->get_allocation_mean(i);
+  }
+  if (!perf_counters::is_enabled()) return;
+  for (auto column: stats_columns) {
+    for (unsigned i = 0; i < perf_counters::NUM_COUNTERS; i++) {
+      // n/a if the counters never ran during the regions of the column
+      if (column->has_counters()) os << "\t" << column->get_counter_mean(i); else os << "\tn/a";
+    }
+  }
+}
+
+} /* namespace datasketches */
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef TIMING_CORE_H_
+#define TIMING_CORE_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "perf_counters.h"
+#include "counting_allocator.h"
+#include "sweep_shard.h"
+
+namespace datasketches {
+
+/*
+ * Clock used for all measurements, with its overhead and resolution calibrated once per process
+ */
+class timer {
+public:
+  typedef std::chrono::steady_clock clock;
+  typedef clock::time_point time_point;
+
+  static time_point now() { return clock::now(); }
+
+  // nanoseconds since start minus the overhead of reading the clock
+  static double elapsed_ns(time_point start);
+
+  // median cost of a pair of now() calls
+  static double get_overhead_ns();
+
+  // smallest observed nonzero difference between two now() calls
+  static double get_resolution_ns();
+
+  // a sample of a batched measurement should be at least this long
+  static double get_min_sample_ns();
+
+private:
+  struct calibration {
+    double overhead_ns;
+    double resolution_ns;
+    calibration();
+  };
+  static const calibration& get_calibration();
+};
+
+struct timing_summary {
+  size_t num_samples;
+  double median;
+  double mean;
+  double stddev;
+  double ci_low;  // 95% confidence interval of the mean
+  double ci_high;
+};
+
+/*
+ * Samples of one timed operation (a column of a timing profile), in nanoseconds per operation.
+ * Regions that cannot be repeated (building or updating a sketch) are timed once per trial with start() and stop().
+ * Operations that can be repeated (queries) are timed with measure(), which runs warmup calls and then
+ * repeats the operation in a batch long enough to make the clock resolution and overhead negligible.
+ * If hardware counters are enabled, they are accumulated over the same regions, also per operation.
+ * The counters are read outside of the clock readings, so reading them does not affect the time.
+ * Heap usage through counting_allocator is tracked over the same regions: allocations and bytes per operation,
+ * and the peak increase of live bytes during the region.
+ */
+class timing_column {
+public:
+  struct region_start {
+    allocation_stats allocations;
+    perf_counters::values counters;
+    timer::time_point time;
+  };
+
+  explicit timing_column(const std::string& name);
+
+  const std::string& get_name() const;
+
+  region_start start() const;
+  void stop(const region_start& start, size_t num_ops = 1);
+
+  template<typename Fn>
+  void measure(Fn&& fn, size_t ops_per_call = 1);
+
+  void add_sample(double ns_per_op);
+  void clear();
+  timing_summary get_summary() const;
+  double get_mean() const;
+  const std::vector<double>& get_samples() const { return samples; }
+
+  // mean of a hardware counter per operation
+  double get_counter_mean(unsigned counter) const;
+  bool has_counters() const { return num_counter_samples > 0; }
+
+  enum allocation_metric { ALLOCATIONS, ALLOCATED_BYTES, PEAK_BYTES, NUM_ALLOCATION_METRICS };
+  double get_allocation_mean(unsigned metric) const;
+  static const char* get_allocation_metric_name(unsigned metric);
+
+private:
+  static const unsigned NUM_WARMUP_CALLS = 3;
+  static const size_t MAX_BATCH = 1 << 20;
+
+  std::string name;
+  std::vector<double> samples;
+  double counter_sums[perf_counters::NUM_COUNTERS]; // sums of per-operation counts
+  size_t num_counter_samples;
+  double allocation_sums[NUM_ALLOCATION_METRICS];
+  size_t num_allocation_samples;
+
+  void add_counters(const perf_counters::values& start, const perf_counters::values& finish, size_t num_ops);
+  void add_allocations(const allocation_stats& start, size_t num_ops);
+};
+
+inline timing_column::region_start timing_column::start() const {
+  region_start start;
+  allocation_stats& stats = allocation_stats::get();
+  stats.peak_live_bytes = stats.live_bytes; // to get the peak within the region
+  start.allocations = stats;
+  start.counters = perf_counters::read();
+  start.time = timer::now();
+  return start;
+}
+
+template<typename Fn>
+void timing_column::measure(Fn&& fn, size_t ops_per_call) {
+  for (unsigned i = 0; i < NUM_WARMUP_CALLS; i++) fn();
+  // batches that turn out to be too short serve as more warmup
+  for (size_t batch = 1; ; batch *= 2) {
+    const region_start start = this->start();
+    for (size_t i = 0; i < batch; i++) fn();
+    const double elapsed_ns = timer::elapsed_ns(start.time);
+    if (elapsed_ns >= timer::get_min_sample_ns() || batch >= MAX_BATCH) {
+      add_counters(start.counters, perf_counters::read(), batch * ops_per_call);
+      add_allocations(start.allocations, batch * ops_per_call);
+      add_sample(elapsed_ns / batch / ops_per_call);
+      return;
+    }
+  }
+}
+
+// prevents the compiler from optimizing away a computation whose result is not used
+template<typename T>
+inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// column names of the statistics appended to the row of a timing profile for the given columns
+void print_timing_summary_header(std::ostream& os, const std::vector<timing_column*>& columns);
+
+// same with the allocation and counter statistics only for stats_columns, they are per thread,
+// so they do not cover columns whose regions run on several threads
+void print_timing_summary_header(std::ostream& os, const std::vector<timing_column*>& columns,
+    const std::vector<timing_column*>& stats_columns);
+
+// samples of the given columns for the JSON output
+raw_samples get_raw_samples(const std::vector<timing_column*>& columns);
+
+// tab-separated median, standard deviation and confidence interval of the mean for each column,
+// followed by allocations per operation for each column,
+// and hardware counters per operation for each column if they are enabled
+void print_timing_summary(std::ostream& os, const std::vector<timing_column*>& columns);
+void print_timing_summary(std::ostream& os, const std::vector<timing_column*>& columns,
+    const std::vector<timing_column*>& stats_columns);
+
+} /* namespace datasketches */
+
+#endif /* TIMING_CORE_H_ */
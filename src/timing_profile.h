@@ -0,0 +1,369 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef TIMING_PROFILE_H_
+#define TIMING_PROFILE_H_
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "profile.h"
+#include "characterization_utils.h"
+#include "timing_core.h"
+#include "serialization_buffer.h"
+
+namespace datasketches {
+
+/*
+ * Timing profile of a sketch, generic over a policy type that declares the sketch and its operations:
+ *
+ *   typedef ... sketch_type;
+ *   typedef ... item_type;
+ *   static const size_t lg_min_trials, lg_max_trials;
+ *   static const size_t lg_max_stream_len;                           // optional, 23 if not declared
+ *   sketch_type build();
+ *   const item_type* get_items(size_t stream_length, size_t trial); // input of a trial, not timed
+ *   auto make_operations();                                          // std::tuple of operations
+ *
+ * Every trial times build() and the update of the sketch with the items, and then runs the operations
+ * in the order of the tuple. Each operation reports its own columns after Build and Update, in the same order.
+ * An operation is a class with:
+ *
+ *   void header(std::ostream&) const;                  // tab-prefixed column names
+ *   void add_columns(std::vector<timing_column*>&);    // timing columns for the summary statistics
+ *   void clear();                                      // discard the measurements of the warmup trials
+ *   void run(const sketch_type&, const item_type* items, size_t stream_length);
+ *   void print(std::ostream&, size_t num_trials) const; // tab-prefixed values
+ *
+ * query_timing, the serde timings and statistic below cover the usual cases.
+ * Everything is resolved at compile time, so the timed regions contain direct calls that can be inlined,
+ * and all sketches are measured with the same sweep, warmup and per trial timing.
+ */
+template<typename SketchTraits>
+class timing_profile: public profile {
+public:
+  virtual void run(sweep_shard& shard);
+};
+
+// the sweep of timing_profile with traits constructed by the caller, for traits that take parameters
+template<typename SketchTraits>
+void run_timing_sweep(sweep_shard& shard, SketchTraits& traits);
+
+// the end of the sweep: SketchTraits::lg_max_stream_len if declared, for inputs that are expensive to hold
+template<typename SketchTraits, typename = void>
+struct lg_max_stream_len_of {
+  static const size_t value = 23;
+};
+
+template<typename SketchTraits>
+struct lg_max_stream_len_of<SketchTraits, decltype((void) SketchTraits::lg_max_stream_len)> {
+  static const size_t value = SketchTraits::lg_max_stream_len;
+};
+
+template<typename Tuple, typename Fn, size_t... I>
+void for_each_operation(Tuple& operations, Fn&& fn, std::index_sequence<I...>) {
+  const int expand[] = {0, (fn(std::get<I>(operations)), 0)...};
+  (void) expand;
+}
+
+template<typename Tuple, typename Fn>
+void for_each_operation(Tuple& operations, Fn&& fn) {
+  for_each_operation(operations, std::forward<Fn>(fn), std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+template<typename SketchTraits>
+void timing_profile<SketchTraits>::run(sweep_shard& shard) {
+  SketchTraits traits;
+  run_timing_sweep(shard, traits);
+}
+
+template<typename SketchTraits>
+void run_timing_sweep(sweep_shard& shard, SketchTraits& traits) {
+  const size_t lg_min_stream_len(0);
+  const size_t lg_max_stream_len(lg_max_stream_len_of<SketchTraits>::value);
+  const size_t ppo(16);
+
+  const size_t num_warmup_trials(4);
+
+  typedef typename SketchTraits::sketch_type sketch_type;
+  typedef typename SketchTraits::item_type item_type;
+
+  auto operations = traits.make_operations();
+
+  timing_column build("Build");
+  timing_column update("Update");
+  std::vector<timing_column*> columns = {&build, &update};
+  for_each_operation(operations, [&columns](auto& operation) { operation.add_columns(columns); });
+
+  shard.header() << "Stream\tTrials\tBuild\tUpdate";
+  for_each_operation(operations, [&shard](const auto& operation) { operation.header(shard.header()); });
+  print_timing_summary_header(shard.header(), columns);
+  shard.header() << std::endl;
+
+  for (size_t stream_length = 1 << lg_min_stream_len; stream_length <= (1 << lg_max_stream_len); stream_length = pwr_2_law_next(ppo, stream_length)) {
+    if (!shard.should_run(stream_length)) continue;
+
+    const size_t num_trials = get_num_trials(stream_length, lg_min_stream_len, lg_max_stream_len,
+        SketchTraits::lg_min_trials, SketchTraits::lg_max_trials);
+    for (size_t i = 0; i < num_warmup_trials + num_trials; i++) {
+      if (i == num_warmup_trials) {
+        // discard measurements of the warmup trials
+        build.clear();
+        update.clear();
+        for_each_operation(operations, [](auto& operation) { operation.clear(); });
+      }
+      const item_type* items = traits.get_items(stream_length, i);
+
+      const auto start_build(build.start());
+      sketch_type sketch(traits.build());
+      build.stop(start_build);
+
+      const auto start_update(update.start());
+      for (size_t j = 0; j < stream_length; j++) sketch.update(items[j]);
+      update.stop(start_update, stream_length);
+
+      for_each_operation(operations, [&](auto& operation) { operation.run(sketch, items, stream_length); });
+    }
+
+    shard.add_row_samples(get_raw_samples(columns));
+    shard.out() << stream_length << "\t"
+        << num_trials << "\t"
+        << build.get_mean() << "\t"
+        << update.get_mean();
+    for_each_operation(operations, [&shard, num_trials](const auto& operation) { operation.print(shard.out(), num_trials); });
+    print_timing_summary(shard.out(), columns);
+    shard.out() << std::endl;
+  }
+}
+
+// query repeated with timing_column::measure(), query(sketch) does ops_per_call operations
+template<typename Query>
+class query_timing {
+public:
+  query_timing(const std::string& name, Query query, size_t ops_per_call): column(name), query(query), ops_per_call(ops_per_call) {}
+  void header(std::ostream& os) const { os << "\t" << column.get_name(); }
+  void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&column); }
+  void clear() { column.clear(); }
+  template<typename Sketch, typename T>
+  void run(const Sketch& sketch, const T*, size_t) { column.measure([&]() { query(sketch); }, ops_per_call); }
+  void print(std::ostream& os, size_t) const { os << "\t" << column.get_mean(); }
+private:
+  timing_column column;
+  Query query;
+  size_t ops_per_call;
+};
+
+template<typename Query>
+query_timing<Query> make_query_timing(const std::string& name, Query query, size_t ops_per_call = 1) {
+  return query_timing<Query>(name, query, ops_per_call);
+}
+
+// serialize(sketch, std::ostream&) and deserialize(std::istream&) through a std::stringstream
+template<typename Serialize, typename Deserialize>
+class stream_serde_timing {
+public:
+  stream_serde_timing(const std::string& serialize_name, const std::string& deserialize_name, Serialize serialize, Deserialize deserialize):
+    serialize_column(serialize_name), deserialize_column(deserialize_name), serialize(serialize), deserialize(deserialize) {}
+  void header(std::ostream& os) const { os << "\t" << serialize_column.get_name() << "\t" << deserialize_column.get_name(); }
+  void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&serialize_column); columns.push_back(&deserialize_column); }
+  void clear() { serialize_column.clear(); deserialize_column.clear(); }
+  template<typename Sketch, typename T>
+  void run(const Sketch& sketch, const T*, size_t) {
+    std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+    const auto start_serialize(serialize_column.start());
+    serialize(sketch, s);
+    serialize_column.stop(start_serialize);
+
+    const auto start_deserialize(deserialize_column.start());
+    auto deserialized_sketch = deserialize(s);
+    deserialize_column.stop(start_deserialize);
+    do_not_optimize(deserialized_sketch);
+  }
+  void print(std::ostream& os, size_t) const { os << "\t" << serialize_column.get_mean() << "\t" << deserialize_column.get_mean(); }
+private:
+  timing_column serialize_column;
+  timing_column deserialize_column;
+  Serialize serialize;
+  Deserialize deserialize;
+};
+
+template<typename Serialize, typename Deserialize>
+stream_serde_timing<Serialize, Deserialize> make_stream_serde_timing(const std::string& serialize_name, const std::string& deserialize_name,
+    Serialize serialize, Deserialize deserialize) {
+  return stream_serde_timing<Serialize, Deserialize>(serialize_name, deserialize_name, serialize, deserialize);
+}
+
+// serialize(sketch) returning a pair of bytes and size, and deserialize(const void*, size_t)
+template<typename Serialize, typename Deserialize>
+class bytes_serde_timing {
+public:
+  bytes_serde_timing(const std::string& serialize_name, const std::string& deserialize_name, Serialize serialize, Deserialize deserialize):
+    serialize_column(serialize_name), deserialize_column(deserialize_name), serialize(serialize), deserialize(deserialize) {}
+  void header(std::ostream& os) const { os << "\t" << serialize_column.get_name() << "\t" << deserialize_column.get_name(); }
+  void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&serialize_column); columns.push_back(&deserialize_column); }
+  void clear() { serialize_column.clear(); deserialize_column.clear(); }
+  template<typename Sketch, typename T>
+  void run(const Sketch& sketch, const T*, size_t) {
+    const auto start_serialize(serialize_column.start());
+    auto pair = serialize(sketch);
+    serialize_column.stop(start_serialize);
+
+    const auto start_deserialize(deserialize_column.start());
+    auto deserialized_sketch = deserialize(pair.first.get(), pair.second);
+    deserialize_column.stop(start_deserialize);
+    do_not_optimize(deserialized_sketch);
+  }
+  void print(std::ostream& os, size_t) const { os << "\t" << serialize_column.get_mean() << "\t" << deserialize_column.get_mean(); }
+private:
+  timing_column serialize_column;
+  timing_column deserialize_column;
+  Serialize serialize;
+  Deserialize deserialize;
+};
+
+template<typename Serialize, typename Deserialize>
+bytes_serde_timing<Serialize, Deserialize> make_bytes_serde_timing(const std::string& serialize_name, const std::string& deserialize_name,
+    Serialize serialize, Deserialize deserialize) {
+  return bytes_serde_timing<Serialize, Deserialize>(serialize_name, deserialize_name, serialize, deserialize);
+}
+
+// size of the sketch serialized to a stream
+template<typename Sketch>
+size_t get_serialized_size_bytes(const Sketch& sketch) {
+  std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+  sketch.serialize(s);
+  return s.tellp();
+}
+
+/*
+ * serialize(sketch, std::ostream&) into a preallocated buffer through fixed_streambuf,
+ * and deserialize(const void*, size_t) straight from the buffer.
+ * This measures the wire format without the allocations of std::stringstream and of the serialize() byte pair.
+ * The buffer grows (not timed) if a sketch does not fit.
+ */
+template<typename Serialize, typename Deserialize>
+class buffer_serde_timing {
+public:
+  buffer_serde_timing(const std::string& serialize_name, const std::string& deserialize_name, Serialize serialize, Deserialize deserialize):
+    serialize_column(serialize_name), deserialize_column(deserialize_name), serialize(serialize), deserialize(deserialize), buffer(1 << 16) {}
+  void header(std::ostream& os) const { os << "\t" << serialize_column.get_name() << "\t" << deserialize_column.get_name(); }
+  void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&serialize_column); columns.push_back(&deserialize_column); }
+  void clear() { serialize_column.clear(); deserialize_column.clear(); }
+  template<typename Sketch, typename T>
+  void run(const Sketch& sketch, const T*, size_t) {
+    const size_t size_bytes = get_serialized_size_bytes(sketch);
+    if (buffer.size() < size_bytes) buffer.resize(size_bytes);
+    fixed_streambuf buf(buffer.data(), buffer.size());
+    std::ostream os(&buf);
+
+    const auto start_serialize(serialize_column.start());
+    serialize(sketch, os);
+    serialize_column.stop(start_serialize);
+    if (!os) throw std::runtime_error("serialization into the preallocated buffer failed");
+
+    const auto start_deserialize(deserialize_column.start());
+    auto deserialized_sketch = deserialize(buffer.data(), buf.size());
+    deserialize_column.stop(start_deserialize);
+    do_not_optimize(deserialized_sketch);
+  }
+  void print(std::ostream& os, size_t) const { os << "\t" << serialize_column.get_mean() << "\t" << deserialize_column.get_mean(); }
+private:
+  timing_column serialize_column;
+  timing_column deserialize_column;
+  Serialize serialize;
+  Deserialize deserialize;
+  std::vector<char> buffer;
+};
+
+template<typename Serialize, typename Deserialize>
+buffer_serde_timing<Serialize, Deserialize> make_buffer_serde_timing(const std::string& serialize_name, const std::string& deserialize_name,
+    Serialize serialize, Deserialize deserialize) {
+  return buffer_serde_timing<Serialize, Deserialize>(serialize_name, deserialize_name, serialize, deserialize);
+}
+
+/*
+ * Like buffer_serde_timing, but the sketches of consecutive trials are written back to back into a memory mapped file,
+ * and deserialize(const void*, size_t) reads straight from the mapping.
+ * Writing starts over at the beginning of the file when it is full.
+ */
+template<typename Serialize, typename Deserialize>
+class mapped_serde_timing {
+public:
+  static const size_t CAPACITY_BYTES = 1ULL << 28;
+
+  mapped_serde_timing(const std::string& serialize_name, const std::string& deserialize_name, Serialize serialize, Deserialize deserialize):
+    serialize_column(serialize_name), deserialize_column(deserialize_name), serialize(serialize), deserialize(deserialize),
+    buffer(new mapped_buffer(CAPACITY_BYTES)), offset(0) {}
+  void header(std::ostream& os) const { os << "\t" << serialize_column.get_name() << "\t" << deserialize_column.get_name(); }
+  void add_columns(std::vector<timing_column*>& columns) { columns.push_back(&serialize_column); columns.push_back(&deserialize_column); }
+  void clear() { serialize_column.clear(); deserialize_column.clear(); }
+  template<typename Sketch, typename T>
+  void run(const Sketch& sketch, const T*, size_t) {
+    const size_t size_bytes = get_serialized_size_bytes(sketch);
+    if (size_bytes > buffer->capacity()) throw std::runtime_error("serialized sketch does not fit into the mapped file");
+    if (offset + size_bytes > buffer->capacity()) offset = 0;
+    char* ptr = buffer->data() + offset;
+    fixed_streambuf buf(ptr, buffer->capacity() - offset);
+    std::ostream os(&buf);
+
+    const auto start_serialize(serialize_column.start());
+    serialize(sketch, os);
+    serialize_column.stop(start_serialize);
+    if (!os) throw std::runtime_error("serialization into the mapped file failed");
+
+    const auto start_deserialize(deserialize_column.start());
+    auto deserialized_sketch = deserialize(ptr, buf.size());
+    deserialize_column.stop(start_deserialize);
+    do_not_optimize(deserialized_sketch);
+
+    offset += (buf.size() + 7) & ~7ULL; // keep the next sketch 8-byte aligned
+  }
+  void print(std::ostream& os, size_t) const { os << "\t" << serialize_column.get_mean() << "\t" << deserialize_column.get_mean(); }
+private:
+  timing_column serialize_column;
+  timing_column deserialize_column;
+  Serialize serialize;
+  Deserialize deserialize;
+  std::shared_ptr<mapped_buffer> buffer; // shared to keep the operation copyable for std::make_tuple
+  size_t offset;
+};
+
+template<typename Serialize, typename Deserialize>
+mapped_serde_timing<Serialize, Deserialize> make_mapped_serde_timing(const std::string& serialize_name, const std::string& deserialize_name,
+    Serialize serialize, Deserialize deserialize) {
+  return mapped_serde_timing<Serialize, Deserialize>(serialize_name, deserialize_name, serialize, deserialize);
+}
+
+// mean over the trials of a value computed from the sketch, not timed
+template<typename Fn>
+class statistic {
+public:
+  statistic(const std::string& name, Fn fn): name(name), fn(fn), sum(0) {}
+  void header(std::ostream& os) const { os << "\t" << name; }
+  void add_columns(std::vector<timing_column*>&) {}
+  void clear() { sum = 0; }
+  template<typename Sketch, typename T>
+  void run(const Sketch& sketch, const T*, size_t) { sum += (double) fn(sketch); }
+  void print(std::ostream& os, size_t num_trials) const { os << "\t" << sum / num_trials; }
+private:
+  std::string name;
+  Fn fn;
+  double sum;
+};
+
+template<typename Fn>
+statistic<Fn> make_statistic(const std::string& name, Fn fn) {
+  return statistic<Fn>(name, fn);
+}
+
+} /* namespace datasketches */
+
+#endif /* TIMING_PROFILE_H_ */
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "trace_input.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+namespace datasketches {
+
+// FNV-1a, for keys that are not numbers
+static uint64_t hash_key(const char* begin, const char* end) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const char* p = begin; p != end; p++) {
+    hash ^= static_cast<unsigned char>(*p);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static bool parse_integer(const char* begin, const char* end, uint64_t& value) {
+  const bool negative = begin != end && *begin == '-';
+  if (negative) begin++;
+  if (begin == end || end - begin > 19) return false;
+  uint64_t result = 0;
+  for (const char* p = begin; p != end; p++) {
+    if (*p < '0' || *p > '9') return false;
+    result = result * 10 + (*p - '0');
+  }
+  value = negative ? ~result + 1 : result;
+  return true;
+}
+
+template<typename T>
+static void parse_item(const char* begin, const char* end, size_t, T& item) {
+  uint64_t value;
+  if (!parse_integer(begin, end, value)) value = hash_key(begin, end);
+  item = static_cast<T>(value);
+}
+
+// the mapping is not null-terminated, so the number is copied for strtod
+static double parse_number(const char* begin, const char* end, size_t line_number) {
+  char number[64];
+  const size_t length = end - begin;
+  char* number_end = nullptr;
+  double value = 0;
+  if (length < sizeof(number)) {
+    memcpy(number, begin, length);
+    number[length] = 0;
+    value = strtod(number, &number_end);
+  }
+  if (number_end != number + length) {
+    throw std::invalid_argument("not a number on line " + std::to_string(line_number) + " of the trace");
+  }
+  return value;
+}
+
+static void parse_item(const char* begin, const char* end, size_t line_number, float& item) {
+  item = parse_number(begin, end, line_number);
+}
+
+static void parse_item(const char* begin, const char* end, size_t line_number, double& item) {
+  item = parse_number(begin, end, line_number);
+}
+
+static bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+template<typename T>
+void parse_trace(const char* data, size_t size, std::vector<T>& items) {
+  items.clear();
+  items.reserve(size / 8);
+  const char* end = data + size;
+  size_t line_number = 0;
+  for (const char* line = data; line < end;) {
+    const char* newline = static_cast<const char*>(memchr(line, '\n', end - line));
+    const char* line_end = newline != nullptr ? newline : end;
+    line_number++;
+    const char* begin = line;
+    const char* last = line_end;
+    while (begin != last && is_space(*begin)) begin++;
+    while (last != begin && is_space(last[-1])) last--;
+    if (begin != last) {
+      items.push_back(T());
+      parse_item(begin, last, line_number, items.back());
+    }
+    line = line_end + 1;
+  }
+}
+
+template void parse_trace(const char*, size_t, std::vector<float>&);
+template void parse_trace(const char*, size_t, std::vector<double>&);
+template void parse_trace(const char*, size_t, std::vector<long>&);
+template void parse_trace(const char*, size_t, std::vector<long long>&);
+template void parse_trace(const char*, size_t, std::vector<unsigned long>&);
+template void parse_trace(const char*, size_t, std::vector<unsigned long long>&);
+
+bool get_binary_trace(const std::string& path, const mapped_file& file, size_t item_size, size_t& offset, size_t& num_items) {
+  dataset_header header;
+  if (dataset_cache::read_header(file, header)) {
+    if (header.version != dataset_cache::FORMAT_VERSION) {
+      throw std::invalid_argument("trace " + path + " is a dataset of format version " + std::to_string(header.version)
+          + ", expected " + std::to_string(dataset_cache::FORMAT_VERSION));
+    }
+    if (!dataset_cache::is_valid(file, item_size, header.num_items)) {
+      throw std::invalid_argument("trace " + path + " is not a dataset of items of " + std::to_string(item_size) + " bytes");
+    }
+    offset = dataset_cache::HEADER_SIZE_BYTES;
+    num_items = header.num_items;
+    return true;
+  }
+  const std::string extension(".bin");
+  if (path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+    if (file.size() % item_size != 0) {
+      throw std::invalid_argument("size of trace " + path + " is not a multiple of " + std::to_string(item_size) + " bytes");
+    }
+    offset = 0;
+    num_items = file.size() / item_size;
+    return true;
+  }
+  return false;
+}
+
+} /* namespace datasketches */
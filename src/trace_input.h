@@ -0,0 +1,114 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef TRACE_INPUT_H_
+#define TRACE_INPUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "dataset_cache.h"
+#include "characterization_utils.h"
+
+namespace datasketches {
+
+// bulk parsing of a newline-delimited trace, one item per line
+// integer items are decimal numbers, any other line is a key and is replaced by its 64-bit hash
+// floating point items must be numbers
+// instantiated for float, double and the integer types of 64 bits
+template<typename T>
+void parse_trace(const char* data, size_t size, std::vector<T>& items);
+
+// offset and number of the items if the mapped file is a binary trace of items of the given size, otherwise false
+// binary traces are dataset cache files, or raw arrays of items in native byte order with a .bin extension
+bool get_binary_trace(const std::string& path, const mapped_file& file, size_t item_size, size_t& offset, size_t& num_items);
+
+/*
+ * Window of stream_length items of an input for the given trial, a different one for each trial.
+ * A stream longer than the input replays it from the start as many times as needed,
+ * copied chunk by chunk into the buffer.
+ */
+template<typename T>
+const T* get_window(const T* input, size_t input_length, size_t stream_length, size_t trial, std::vector<T>& buffer) {
+  if (stream_length <= input_length) {
+    return input + (trial * stream_length) % (input_length - stream_length + 1);
+  }
+  buffer.resize(stream_length);
+  for (size_t offset = 0; offset < stream_length; offset += input_length) {
+    std::copy(input, input + std::min(input_length, stream_length - offset), buffer.data() + offset);
+  }
+  return buffer.data();
+}
+
+/*
+ * Items of a recorded trace, for example captured traffic, read through a memory mapping.
+ * A binary trace is used in place without copying. A text trace is parsed once in bulk
+ * from the mapping, with no stream or per line allocation.
+ */
+template<typename T>
+class trace_file {
+public:
+  explicit trace_file(const std::string& path): file(path), items(nullptr), num_items(0) {
+    size_t offset;
+    if (get_binary_trace(path, file, sizeof(T), offset, num_items)) {
+      items = reinterpret_cast<const T*>(static_cast<const char*>(file.data()) + offset);
+    } else {
+      parse_trace(static_cast<const char*>(file.data()), file.size(), parsed);
+      items = parsed.data();
+      num_items = parsed.size();
+    }
+    if (num_items == 0) throw std::runtime_error("empty trace " + path);
+  }
+
+  const T* data() const { return items; }
+  size_t size() const { return num_items; }
+
+private:
+  mapped_file file;
+  std::vector<T> parsed;
+  const T* items;
+  size_t num_items;
+};
+
+/*
+ * Input of a timing profile: the trace named by CHARACTERIZATION_TRACE if it is set,
+ * otherwise a generated dataset from the dataset cache.
+ * Each trial reads a different window of the input, see get_window().
+ */
+template<typename T>
+class timing_input {
+public:
+  timing_input(const std::string& dataset_key, size_t dataset_length, const std::function<void(T*, size_t)>& generate) {
+    const std::string path = get_trace_path();
+    if (path.empty()) {
+      dataset.reset(new mapped_dataset<T>(dataset_cache().get<T>(dataset_key, dataset_length, generate)));
+    } else {
+      trace.reset(new trace_file<T>(path));
+    }
+  }
+
+  bool is_trace() const { return trace != nullptr; }
+  const T* data() const { return trace ? trace->data() : dataset->data(); }
+  size_t size() const { return trace ? trace->size() : dataset->size(); }
+
+  const T* get_items(size_t stream_length, size_t trial) {
+    return get_window(data(), size(), stream_length, trial, buffer);
+  }
+
+private:
+  std::unique_ptr<mapped_dataset<T>> dataset;
+  std::unique_ptr<trace_file<T>> trace;
+  std::vector<T> buffer;
+};
+
+} /* namespace datasketches */
+
+#endif /* TRACE_INPUT_H_ */
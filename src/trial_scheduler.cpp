@@ -0,0 +1,96 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#include "trial_scheduler.h"
+#include "cpu_isolation.h"
+
+namespace datasketches {
+
+trial_scheduler::trial_scheduler(unsigned num_threads):
+num_threads(num_threads > 0 ? num_threads : get_pinned_cpus().size()),
+generation(0),
+stopping(false),
+num_busy(0),
+fn(nullptr),
+num_trials(0),
+next_trial(0)
+{
+  if (this->num_threads == 0) this->num_threads = std::thread::hardware_concurrency();
+  if (this->num_threads == 0) this->num_threads = 1; // hardware_concurrency() may be unknown
+}
+
+trial_scheduler::~trial_scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  start_condition.notify_all();
+  for (auto& thread: threads) thread.join();
+}
+
+unsigned trial_scheduler::get_num_threads() const {
+  return num_threads;
+}
+
+void trial_scheduler::run(size_t num_trials, const std::function<void(unsigned, size_t)>& fn) {
+  if (threads.empty()) {
+    for (unsigned i = 1; i < num_threads; i++) threads.emplace_back(&trial_scheduler::work, this, i);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->fn = &fn;
+    this->num_trials = num_trials;
+    next_trial = 0;
+    error = nullptr;
+    num_busy = threads.size();
+    generation++;
+  }
+  start_condition.notify_all();
+
+  run_trials(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_condition.wait(lock, [this]() { return num_busy == 0; });
+  this->fn = nullptr;
+  if (error) std::rethrow_exception(error);
+}
+
+void trial_scheduler::work(unsigned worker_index) {
+  bool pinned = false;
+  uint64_t last_generation = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    start_condition.wait(lock, [this, last_generation]() { return stopping || generation != last_generation; });
+    if (stopping) return;
+    last_generation = generation;
+    lock.unlock();
+    if (!pinned) {
+      try {
+        pin_thread(worker_index);
+      } catch (...) {
+        std::lock_guard<std::mutex> error_lock(mutex);
+        if (!error) error = std::current_exception();
+        next_trial = num_trials; // stop handing out trials
+      }
+      pinned = true;
+    }
+    run_trials(worker_index);
+    lock.lock();
+    if (--num_busy == 0) done_condition.notify_one();
+  }
+}
+
+void trial_scheduler::run_trials(unsigned worker_index) {
+  try {
+    size_t trial;
+    while ((trial = next_trial++) < num_trials) (*fn)(worker_index, trial);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error) error = std::current_exception();
+    next_trial = num_trials; // stop handing out trials
+  }
+}
+
+} /* namespace datasketches */
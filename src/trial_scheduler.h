@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019, Verizon Media.
+ * Licensed under the terms of the Apache License 2.0. See LICENSE file at the project root for terms.
+ */
+
+#ifndef TRIAL_SCHEDULER_H_
+#define TRIAL_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <exception>
+
+namespace datasketches {
+
+/*
+ * Spreads independent trials across a pool of worker threads.
+ * Each trial is identified by its index, and each call of the trial function receives
+ * the index of the worker executing it, so that workers can own their buffers and state.
+ * Trials are handed out dynamically, therefore the function must not depend on the order
+ * of execution: results should be stored by trial index or combined in an order-independent way.
+ * The worker threads are started by the first run() and wait for the next run() until the scheduler
+ * is destroyed, so a profile creates one scheduler and calls run() as often as it needs.
+ * With --cpus, worker i is pinned to the i-th of the CPUs.
+ */
+class trial_scheduler {
+public:
+  // num_threads = 0 means one thread per pinned CPU, or per hardware thread if not pinned
+  explicit trial_scheduler(unsigned num_threads = 0);
+  ~trial_scheduler();
+
+  trial_scheduler(const trial_scheduler&) = delete;
+  trial_scheduler& operator=(const trial_scheduler&) = delete;
+
+  unsigned get_num_threads() const;
+
+  // runs fn(worker_index, trial_index) for every trial_index in [0, num_trials)
+  // the calling thread is worker 0
+  void run(size_t num_trials, const std::function<void(unsigned, size_t)>& fn);
+
+private:
+  unsigned num_threads;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable start_condition;
+  std::condition_variable done_condition;
+  uint64_t generation; // number of runs started, workers wait for it to change
+  bool stopping;
+  unsigned num_busy; // workers that have not finished the current run
+
+  const std::function<void(unsigned, size_t)>* fn;
+  size_t num_trials;
+  std::atomic<size_t> next_trial;
+  std::exception_ptr error;
+
+  void work(unsigned worker_index);
+  void run_trials(unsigned worker_index);
+};
+
+} /* namespace datasketches */
+
+#endif /* TRIAL_SCHEDULER_H_ */
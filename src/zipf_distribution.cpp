@@ -17,18 +17,33 @@
 namespace datasketches {
 
 zipf_distribution::zipf_distribution(unsigned num_elements, double exponent):
+      zipf_distribution(num_elements, exponent, std::chrono::system_clock::now().time_since_epoch().count())
+{}
+
+zipf_distribution::zipf_distribution(unsigned num_elements, double exponent, uint64_t seed, sampling_method method):
       num_elements(num_elements),
       exponent(exponent),
       h_integral_x1(h_integral(1.5) - 1),
       h_integral_num_elements(h_integral(num_elements + F_1_2)),
       s(2 - h_integral_inverse(h_integral(2.5) - h(2))),
-      generator(std::chrono::system_clock::now().time_since_epoch().count()),
+      method(method),
+      generator(seed),
       distribution(0, 1)
 {
   if (exponent <= 0) throw std::invalid_argument("exponent must be positive");
+  if (method == ALIAS_TABLE) {
+    if (num_elements > MAX_ALIAS_TABLE_SIZE) throw std::invalid_argument("too many elements for alias table");
+    build_alias_table();
+  }
+}
+
+void zipf_distribution::seed(uint64_t seed) {
+  generator.seed(seed);
+  distribution.reset();
 }
 
 unsigned zipf_distribution::sample() {
+  if (method == ALIAS_TABLE) return sample_alias_table();
   while (true) {
     const double u = h_integral_num_elements + distribution(generator) * (h_integral_x1 - h_integral_num_elements);
     double x = h_integral_inverse(u);
@@ -44,6 +59,84 @@ unsigned zipf_distribution::sample() {
   }
 }
 
+/*
+ * The same rejection-inversion steps as in sample(), but for a block of candidates at once.
+ * Each step is a separate loop over the lanes with branches replaced by selects,
+ * which lets the compiler evaluate log, exp, log1p and expm1 in vector registers.
+ * Candidates are drawn and accepted in the same order as by consecutive calls of sample(),
+ * and no more than n uniform values are consumed, so the output is identical.
+ */
+unsigned zipf_distribution::sample_lanes(unsigned* out, unsigned n) {
+  if (method == ALIAS_TABLE) {
+    for (unsigned i = 0; i < n; i++) out[i] = sample_alias_table();
+    return n;
+  }
+
+  double u[LANES];
+  for (unsigned i = 0; i < n; i++) {
+    u[i] = h_integral_num_elements + distribution(generator) * (h_integral_x1 - h_integral_num_elements);
+  }
+
+  // x = h_integral_inverse(u)
+  double x[LANES];
+  for (unsigned i = 0; i < n; i++) {
+    double t = u[i] * (1 - exponent);
+    t = t < -1 ? -1 : t;
+    const double helper = std::abs(t) > TAYLOR_THRESHOLD ? log1p(t) / t : 1 - t * (F_1_2 - t * (F_1_3 - F_1_4 * t));
+    x[i] = exp(helper * u[i]);
+  }
+
+  double k[LANES];
+  for (unsigned i = 0; i < n; i++) {
+    // same truncation as the conversion to unsigned in sample()
+    const double r = floor(x[i] + F_1_2);
+    k[i] = r < 1 ? 1 : (r > num_elements ? num_elements : r);
+  }
+
+  // the squeeze test accepts most candidates, h_integral(k + 1/2) - h(k) is only needed for the rest
+  unsigned num_accepted = 0;
+  for (unsigned i = 0; i < n; i++) {
+    if (k[i] - x[i] <= s || u[i] >= h_integral(k[i] + F_1_2) - h(k[i])) out[num_accepted++] = k[i];
+  }
+  return num_accepted;
+}
+
+void zipf_distribution::build_alias_table() {
+  std::vector<double> scaled(num_elements);
+  double total = 0;
+  for (unsigned i = 0; i < num_elements; i++) {
+    scaled[i] = h(i + 1);
+    total += scaled[i];
+  }
+  for (unsigned i = 0; i < num_elements; i++) scaled[i] *= num_elements / total;
+
+  alias_probability.resize(num_elements);
+  alias.resize(num_elements);
+  std::vector<unsigned> small;
+  std::vector<unsigned> large;
+  for (unsigned i = 0; i < num_elements; i++) {
+    if (scaled[i] < 1) small.push_back(i); else large.push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    const unsigned l = small.back(); small.pop_back();
+    const unsigned g = large.back(); large.pop_back();
+    alias_probability[l] = scaled[l];
+    alias[l] = g;
+    scaled[g] = (scaled[g] + scaled[l]) - 1;
+    if (scaled[g] < 1) small.push_back(g); else large.push_back(g);
+  }
+  // whatever is left is 1 up to rounding errors
+  for (unsigned i: large) { alias_probability[i] = 1; alias[i] = i; }
+  for (unsigned i: small) { alias_probability[i] = 1; alias[i] = i; }
+}
+
+unsigned zipf_distribution::sample_alias_table() {
+  const double u = distribution(generator) * num_elements;
+  unsigned i = u;
+  if (i >= num_elements) i = num_elements - 1;
+  return (u - i < alias_probability[i] ? i : alias[i]) + 1;
+}
+
 double zipf_distribution::h(double x) {
   return exp(-exponent * log(x));
 }
@@ -62,7 +155,7 @@ double zipf_distribution::h_integral_inverse(double x) {
 }
 
 double zipf_distribution::helper1(double x) {
-  if (abs(x) > TAYLOR_THRESHOLD) {
+  if (std::abs(x) > TAYLOR_THRESHOLD) {
       return log1p(x) / x;
   } else {
       return 1 - x * (F_1_2 - x * (F_1_3 - F_1_4 * x));
@@ -70,7 +163,7 @@ double zipf_distribution::helper1(double x) {
 }
 
 double zipf_distribution::helper2(double x) {
-  if (abs(x) > TAYLOR_THRESHOLD) {
+  if (std::abs(x) > TAYLOR_THRESHOLD) {
     return expm1(x) / x;
   } else {
     return 1 + x * F_1_2 * (1 + x * F_1_3 * (1 + F_1_4 * x));
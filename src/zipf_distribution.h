@@ -12,14 +12,32 @@
 
 #include <stdexcept>
 #include <random>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
 
 namespace datasketches {
 
 class zipf_distribution {
 public:
+  enum sampling_method {
+    REJECTION_INVERSION, // no precomputation, works for any number of elements
+    ALIAS_TABLE          // one uniform draw and one table lookup per sample, table is precomputed once
+  };
+
   zipf_distribution(unsigned num_elements, double exponent);
+  zipf_distribution(unsigned num_elements, double exponent, uint64_t seed, sampling_method method = REJECTION_INVERSION);
+  void seed(uint64_t seed);
   unsigned sample();
+
+  // produces the same values as n calls of sample()
+  template<typename T>
+  void sample_n(T* out, size_t n);
+
+  static constexpr unsigned MAX_ALIAS_TABLE_SIZE = 1 << 24;
+
 private:
+  static constexpr unsigned LANES = 8;
   static constexpr double TAYLOR_THRESHOLD = 1e-8;
   static constexpr double F_1_2 = 0.5;
   static constexpr double F_1_3 = 1.0 / 3.0;
@@ -30,10 +48,19 @@ private:
   const double h_integral_x1;
   const double h_integral_num_elements;
   const double s;
+  const sampling_method method;
 
   std::default_random_engine generator;
   std::uniform_real_distribution<double> distribution;
 
+  // Vose's alias method: element i + 1 is chosen with probability alias_probability[i], otherwise alias[i] + 1
+  std::vector<double> alias_probability;
+  std::vector<unsigned> alias;
+
+  void build_alias_table();
+  unsigned sample_alias_table();
+  unsigned sample_lanes(unsigned* out, unsigned n);
+
   double h(double x);
   double h_integral(double x);
   double h_integral_inverse(double x);
@@ -42,6 +69,19 @@ private:
   static double helper2(double x);
 };
 
+// processes up to LANES candidates at a time, accepted lanes are appended to the output,
+// and only as many lanes as there are outstanding samples are refilled in the next round
+template<typename T>
+void zipf_distribution::sample_n(T* out, size_t n) {
+  unsigned block[LANES];
+  size_t i = 0;
+  while (i < n) {
+    const unsigned num_lanes = (n - i) < LANES ? n - i : LANES;
+    const unsigned num_accepted = sample_lanes(block, num_lanes);
+    for (unsigned j = 0; j < num_accepted; j++) out[i++] = block[j];
+  }
+}
+
 } /* namespace datasketches */
 
 #endif